@@ -0,0 +1,144 @@
+// Chunk voxels formats benchmark: encodes chunks with the palette and
+// the plain formats, compares data sizes (before and after extrle) and
+// encoding/decoding time.
+// Chunks are generated by all registered world generators, or read from
+// the world given as argument: ChunkFormatBench [world folder].
+// Built with -DVOXELENGINE_BUILD_BENCHMARKS=ON, runs where res/ is
+#include "fixture.h"
+#include "files/rle.h"
+#include "files/engine_paths.h"
+#include "files/WorldFiles.h"
+#include "voxels/Chunk.h"
+#include "voxels/WorldGenerator.h"
+#include "world/WorldGenerators.h"
+#include "util/timeutil.h"
+
+#include <memory>
+#include <vector>
+#include <iostream>
+#include <stdexcept>
+
+/// @brief Area generated by each generator is AREA_SIZE x AREA_SIZE chunks
+inline constexpr int AREA_SIZE = 8;
+inline constexpr int SEED = 42;
+
+using voxels_buffer = std::unique_ptr<voxel[]>;
+
+struct format_stats {
+    size_t encodedSize = 0;
+    size_t compressedSize = 0;
+    int64_t encodeTime = 0;
+    int64_t decodeTime = 0;
+};
+
+static std::vector<voxels_buffer> generate_chunks() {
+    EnginePaths paths;
+    paths.setResources("res");
+    WorldGenerators::addDefaultGenerators(&paths);
+    std::unique_ptr<Content> content (
+        fixture::build_generators_content(paths.getResources())
+    );
+
+    std::vector<voxels_buffer> chunks;
+    for (const auto& id : WorldGenerators::getGeneratorsIDs()) {
+        std::unique_ptr<WorldGenerator> generator (
+            WorldGenerators::createGenerator(id, content.get())
+        );
+        for (int cz = 0; cz < AREA_SIZE; cz++) {
+            for (int cx = 0; cx < AREA_SIZE; cx++) {
+                auto voxels = std::make_unique<voxel[]>(CHUNK_VOL);
+                generator_context context(cx, cz, SEED);
+                generator->generate(voxels.get(), context);
+                chunks.push_back(std::move(voxels));
+            }
+        }
+    }
+    return chunks;
+}
+
+static std::vector<voxels_buffer> read_chunks(const fs::path& folder) {
+    DebugSettings settings;
+    WorldFiles wfile(folder, settings);
+
+    std::vector<voxels_buffer> chunks;
+    for (const auto& entry : fs::directory_iterator(wfile.getRegionsFolder())) {
+        int x, z;
+        if (entry.path().extension() != ".bin" ||
+            !WorldFiles::parseRegionFilename(entry.path().stem().string(), x, z)) {
+            continue;
+        }
+        for (uint lz = 0; lz < REGION_SIZE; lz++) {
+            for (uint lx = 0; lx < REGION_SIZE; lx++) {
+                size_t size;
+                std::unique_ptr<ubyte[]> data (wfile.getChunk(
+                    x * REGION_SIZE + lx, z * REGION_SIZE + lz, size
+                ));
+                if (data == nullptr) {
+                    continue;
+                }
+                auto voxels = std::make_unique<voxel[]>(CHUNK_VOL);
+                if (!Chunk::decode(data.get(), size, voxels.get())) {
+                    throw std::runtime_error("invalid chunk data");
+                }
+                chunks.push_back(std::move(voxels));
+            }
+        }
+    }
+    return chunks;
+}
+
+/// @param encode encoding function returning data and its length
+template<class F>
+static format_stats measure(const std::vector<voxels_buffer>& chunks, const F& encode) {
+    format_stats stats;
+    auto buffer = std::make_unique<ubyte[]>(CHUNK_ENCODED_MAX_LEN * 2);
+    auto voxels = std::make_unique<voxel[]>(CHUNK_VOL);
+    for (const auto& chunk : chunks) {
+        size_t size;
+        timeutil::Timer encodeTimer;
+        std::unique_ptr<ubyte[]> data (encode(chunk.get(), size));
+        stats.encodeTime += encodeTimer.stop();
+        stats.encodedSize += size;
+        stats.compressedSize += extrle::encode(data.get(), size, buffer.get());
+
+        timeutil::Timer decodeTimer;
+        if (!Chunk::decode(data.get(), size, voxels.get())) {
+            throw std::runtime_error("could not decode encoded chunk");
+        }
+        stats.decodeTime += decodeTimer.stop();
+        for (uint i = 0; i < CHUNK_VOL; i++) {
+            if (voxels[i].id != chunk[i].id || voxels[i].states != chunk[i].states) {
+                throw std::runtime_error("decoded voxels do not match");
+            }
+        }
+    }
+    return stats;
+}
+
+static void report(const char* name, const format_stats& stats, size_t count) {
+    std::cout << name << ": encoded " << stats.encodedSize / count
+              << " B, compressed " << stats.compressedSize / count
+              << " B, encode " << stats.encodeTime / int64_t(count)
+              << " us, decode " << stats.decodeTime / int64_t(count)
+              << " us (per chunk)" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    auto chunks = argc > 1 ? read_chunks(fs::u8path(argv[1])) : generate_chunks();
+    if (chunks.empty()) {
+        std::cout << "no chunks found" << std::endl;
+        return 1;
+    }
+    std::cout << chunks.size() << " chunks" << std::endl;
+
+    auto plain = measure(chunks, [](const voxel* voxels, size_t& size) {
+        size = CHUNK_ENCODED_MAX_LEN;
+        return Chunk::encodePlain(voxels);
+    });
+    auto palette = measure(chunks, [](const voxel* voxels, size_t& size) {
+        return Chunk::encode(voxels, size);
+    });
+    report("plain", plain, chunks.size());
+    report("palette", palette, chunks.size());
+    return 0;
+}
@@ -0,0 +1,129 @@
+// Voxel lookups benchmark: random walk over a chunks matrix through
+// Chunks accessors and ChunkCursor (lookups by coords, steps and
+// neighbours access), prints millions of lookups per second.
+// Built with -DVOXELENGINE_BUILD_BENCHMARKS=ON
+#include "fixture.h"
+#include "voxels/Chunk.h"
+#include "voxels/Chunks.h"
+#include "voxels/ChunkCursor.h"
+#include "world/LevelEvents.h"
+#include "util/timeutil.h"
+
+#include <memory>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+
+inline constexpr int AREA_SIZE = 20;
+inline constexpr int WALK_STEPS = 20000000;
+
+static const int OFFSETS[6][3] {
+    {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}
+};
+
+/// @brief Random walk of neighbour steps staying inside of the area
+static std::vector<int> make_walk() {
+    std::vector<int> steps(WALK_STEPS);
+    int x = 0, y = CHUNK_H / 2, z = 0;
+    // neighbours of the walk positions are inside of the area too
+    constexpr int limit = AREA_SIZE / 2 * CHUNK_W - 2;
+    uint32_t random = 1;
+    for (int i = 0; i < WALK_STEPS; i++) {
+        random = random * 1664525u + 1013904223u;
+        int dir = (random >> 16) % 6;
+        const auto& offset = OFFSETS[dir];
+        if (x + offset[0] < -limit || x + offset[0] > limit ||
+            y + offset[1] < 1 || y + offset[1] >= CHUNK_H - 1 ||
+            z + offset[2] < -limit || z + offset[2] > limit) {
+            dir ^= 1;
+        }
+        x += OFFSETS[dir][0];
+        y += OFFSETS[dir][1];
+        z += OFFSETS[dir][2];
+        steps[i] = dir;
+    }
+    return steps;
+}
+
+/// @param lookup called for each walk position, returns lookup result
+/// @param lookups lookups made by each call
+template<class F>
+static void bench(
+    const char* name, const std::vector<int>& steps, int lookups, const F& lookup
+) {
+    uint64_t sum = 0;
+    int x = 0, y = CHUNK_H / 2, z = 0;
+    timeutil::Timer timer;
+    for (int dir : steps) {
+        x += OFFSETS[dir][0];
+        y += OFFSETS[dir][1];
+        z += OFFSETS[dir][2];
+        sum += lookup(dir, x, y, z);
+    }
+    int64_t time = std::max<int64_t>(timer.stop(), 1);
+    std::cout << name << ": " << double(WALK_STEPS) * lookups / time
+              << " M lookups/s (" << sum << ")" << std::endl;
+}
+
+int main() {
+    std::unique_ptr<Content> content (fixture::build_content(
+        [](ContentBuilder& builder) {
+            fixture::create_block(builder, "bench:stone");
+        }
+    ));
+    blockid_t stone = content->requireBlock("bench:stone").rt.id;
+
+    LevelEvents events;
+    int origin = -AREA_SIZE / 2;
+    Chunks chunks(
+        AREA_SIZE, AREA_SIZE, origin, origin, nullptr, &events, content.get()
+    );
+    for (int z = origin; z < origin + AREA_SIZE; z++) {
+        for (int x = origin; x < origin + AREA_SIZE; x++) {
+            auto chunk = std::make_shared<Chunk>(x, z);
+            auto voxels = std::make_unique<voxel[]>(CHUNK_VOL);
+            for (uint i = 0; i < CHUNK_VOL; i++) {
+                voxels[i] = voxel {i % 7 == 0 ? stone : blockid_t(0), 0};
+            }
+            chunk->voxels.set(voxels.get());
+            chunks.putChunk(chunk);
+        }
+    }
+    auto steps = make_walk();
+
+    bench("Chunks::get", steps, 1, [&](int, int x, int y, int z) {
+        return chunks.get(x, y, z)->id;
+    });
+    bench("Chunks::getLight", steps, 1, [&](int, int x, int y, int z) {
+        return chunks.getLight(x, y, z, 0);
+    });
+    ChunkCursor cursor(chunks);
+    bench("ChunkCursor::get", steps, 1, [&](int, int x, int y, int z) {
+        return cursor.get(x, y, z)->id;
+    });
+    bench("ChunkCursor::getLight", steps, 1, [&](int, int x, int y, int z) {
+        return cursor.getLight(x, y, z, 0);
+    });
+    ChunkCursor walker(chunks);
+    walker.moveTo(0, CHUNK_H / 2, 0);
+    bench("ChunkCursor::step", steps, 1, [&](int dir, int, int, int) {
+        walker.step(OFFSETS[dir][0], OFFSETS[dir][1], OFFSETS[dir][2]);
+        return walker.current()->id;
+    });
+    bench("Chunks::get x6 neighbours", steps, 6, [&](int, int x, int y, int z) {
+        int sum = 0;
+        for (const auto& offset : OFFSETS) {
+            sum += chunks.get(x + offset[0], y + offset[1], z + offset[2])->id;
+        }
+        return sum;
+    });
+    bench("ChunkCursor::neighbour x6", steps, 6, [&](int, int x, int y, int z) {
+        cursor.moveTo(x, y, z);
+        int sum = 0;
+        for (const auto& offset : OFFSETS) {
+            sum += cursor.neighbour(offset[0], offset[1], offset[2])->id;
+        }
+        return sum;
+    });
+    return 0;
+}
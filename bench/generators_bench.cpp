@@ -0,0 +1,51 @@
+// World generators benchmark: generates AREA_SIZE x AREA_SIZE chunks
+// with each registered generator in one thread, prints chunks per second.
+// Built with -DVOXELENGINE_BUILD_BENCHMARKS=ON, runs where res/ is
+#include "fixture.h"
+#include "constants.h"
+#include "files/engine_paths.h"
+#include "voxels/voxel.h"
+#include "voxels/WorldGenerator.h"
+#include "world/WorldGenerators.h"
+#include "util/timeutil.h"
+
+#include <memory>
+#include <iostream>
+#include <algorithm>
+
+inline constexpr int AREA_SIZE = 16;
+inline constexpr int SEED = 42;
+inline constexpr uint HASH_STRIDE = 61;
+
+int main() {
+    EnginePaths paths;
+    paths.setResources("res");
+    WorldGenerators::addDefaultGenerators(&paths);
+    std::unique_ptr<Content> content (
+        fixture::build_generators_content(paths.getResources())
+    );
+
+    auto voxels = std::make_unique<voxel[]>(CHUNK_VOL);
+    for (const auto& id : WorldGenerators::getGeneratorsIDs()) {
+        std::unique_ptr<WorldGenerator> generator (
+            WorldGenerators::createGenerator(id, content.get())
+        );
+        uint64_t hash = fixture::HASH_OFFSET;
+        timeutil::Timer timer;
+        for (int cz = 0; cz < AREA_SIZE; cz++) {
+            for (int cx = 0; cx < AREA_SIZE; cx++) {
+                generator_context context(cx, cz, SEED);
+                generator->generate(voxels.get(), context);
+                // sampled voxels hash to check results did not change
+                for (uint i = 0; i < CHUNK_VOL; i += HASH_STRIDE) {
+                    fixture::hash_combine(hash, voxels[i].id);
+                }
+            }
+        }
+        int64_t time = std::max<int64_t>(timer.stop(), 1);
+        std::cout << id << ": " << AREA_SIZE * AREA_SIZE * 1e6 / time
+                  << " chunks/s (" << std::hex << hash << std::dec << ")"
+                  << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,153 @@
+// Lighting benchmark: relights a generated 9x9 chunks area with lamps
+// in a dark cave, then places and removes an emissive block many times.
+// Built with -DVOXELENGINE_BUILD_BENCHMARKS=ON
+#include "fixture.h"
+#include "lighting/Lighting.h"
+#include "lighting/Lightmap.h"
+#include "voxels/Chunk.h"
+#include "voxels/Chunks.h"
+#include "world/LevelEvents.h"
+#include "util/timeutil.h"
+
+#include <cmath>
+#include <memory>
+#include <random>
+#include <iostream>
+
+/// @brief Chunks matrix size, the outer ring is not relit
+inline constexpr int AREA_SIZE = 11;
+inline constexpr int LAMP_CYCLES = 500;
+inline constexpr int CAVE_BOTTOM = 10;
+inline constexpr int CAVE_TOP = 26;
+inline constexpr uint LAMP_RARITY = 150;
+
+struct bench_blocks {
+    blockid_t stone;
+    blockid_t glass;
+    blockid_t lamp;
+};
+
+static void generate(Chunk& chunk, const bench_blocks& blocks) {
+    auto voxels = std::make_unique<voxel[]>(CHUNK_VOL);
+    for (int y = 0; y < CHUNK_H; y++) {
+        for (int z = 0; z < CHUNK_D; z++) {
+            for (int x = 0; x < CHUNK_W; x++) {
+                int gx = chunk.x * CHUNK_W + x;
+                int gz = chunk.z * CHUNK_D + z;
+                int height = 64 + int(20 * std::sin(gx * 0.05) +
+                                      15 * std::cos(gz * 0.07));
+                uint hash = uint(gx) * 73856093u ^
+                            uint(y) * 19349663u ^
+                            uint(gz) * 83492791u;
+                blockid_t id = y < height ? blocks.stone : 0;
+                if (y < height && y > 30 && hash % 37 == 0) {
+                    id = 0;
+                }
+                if (y < height && hash % LAMP_RARITY == 0) {
+                    id = blocks.lamp;
+                }
+                if (y == height && hash % 7 == 0) {
+                    id = blocks.glass;
+                }
+                if (y >= CAVE_BOTTOM && y < CAVE_TOP) {
+                    bool lamp = y == CAVE_BOTTOM && hash % LAMP_RARITY == 0;
+                    id = lamp ? blocks.lamp : 0;
+                }
+                if (y > height && y < height + 6 && (gx * 7 + gz * 13) % 97 == 0) {
+                    id = blocks.stone;
+                }
+                voxels[vox_index(x, y, z)] = voxel {id, 0};
+            }
+        }
+    }
+    chunk.voxels.set(voxels.get());
+}
+
+static Content* build_content() {
+    return fixture::build_content([](ContentBuilder& builder) {
+        fixture::create_block(builder, "bench:stone");
+
+        Block& glass = fixture::create_block(builder, "bench:glass");
+        glass.lightPassing = true;
+
+        Block& lamp = fixture::create_block(builder, "bench:lamp");
+        lamp.emission[0] = lamp.emission[1] = lamp.emission[2] = 15;
+    });
+}
+
+int main() {
+    std::unique_ptr<Content> content (build_content());
+    auto indices = content->getIndices();
+    bench_blocks blocks {
+        content->requireBlock("bench:stone").rt.id,
+        content->requireBlock("bench:glass").rt.id,
+        content->requireBlock("bench:lamp").rt.id
+    };
+
+    LevelEvents events;
+    auto chunks = std::make_unique<Chunks>(
+        AREA_SIZE, AREA_SIZE, 0, 0, nullptr, &events, content.get()
+    );
+    for (int z = 0; z < AREA_SIZE; z++) {
+        for (int x = 0; x < AREA_SIZE; x++) {
+            auto chunk = std::make_shared<Chunk>(x, z);
+            generate(*chunk, blocks);
+            chunk->updateHeights(indices);
+            Lighting::prebuildSkyLight(chunk.get());
+            chunk->setLoaded(true);
+            chunks->putChunk(chunk);
+        }
+    }
+
+    Lighting lighting(content.get(), chunks.get());
+    timeutil::Timer relightTimer;
+    for (int z = 1; z < AREA_SIZE - 1; z++) {
+        for (int x = 1; x < AREA_SIZE - 1; x++) {
+            lighting.buildSkyLight(x, z);
+            lighting.onChunkLoaded(x, z, true);
+        }
+    }
+    int64_t relightTime = relightTimer.stop();
+
+    // lamps are placed on the cave floor of the inner 5x5 chunks
+    int64_t placeTime = 0;
+    int64_t removeTime = 0;
+    std::mt19937 random(3);
+    for (int i = 0; i < LAMP_CYCLES;) {
+        int x = CHUNK_W * 3 + random() % (CHUNK_W * 5);
+        int z = CHUNK_D * 3 + random() % (CHUNK_D * 5);
+        int y = CAVE_BOTTOM + 5;
+        if (chunks->get(x, y, z)->id != 0) {
+            continue;
+        }
+        chunks->set(x, y, z, blocks.lamp, 0);
+        timeutil::Timer placeTimer;
+        lighting.onBlockSet(x, y, z, blocks.lamp);
+        lighting.flush();
+        placeTime += placeTimer.stop();
+
+        chunks->set(x, y, z, 0, 0);
+        timeutil::Timer removeTimer;
+        lighting.onBlockSet(x, y, z, 0);
+        lighting.flush();
+        removeTime += removeTimer.stop();
+        i++;
+    }
+
+    // lightmaps hash to check results did not change between versions
+    uint64_t hash = fixture::HASH_OFFSET;
+    for (int z = 0; z < AREA_SIZE; z++) {
+        for (int x = 0; x < AREA_SIZE; x++) {
+            auto chunk = chunks->getChunk(x, z);
+            for (uint i = 0; i < CHUNK_VOL; i++) {
+                fixture::hash_combine(hash, chunk->lightmap.map[i]);
+            }
+        }
+    }
+    std::cout << "relight " << AREA_SIZE - 2 << "x" << AREA_SIZE - 2
+              << " chunks: " << relightTime / 1000 << " ms" << std::endl;
+    std::cout << "place lamp: " << placeTime / LAMP_CYCLES << " us" << std::endl;
+    std::cout << "remove lamp: " << removeTime / LAMP_CYCLES << " us" << std::endl;
+    std::cout << "lightmaps hash: " << std::hex << hash << std::endl;
+    return 0;
+}
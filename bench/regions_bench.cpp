@@ -0,0 +1,117 @@
+// Region files reading benchmark: writes a world of REGIONS x REGIONS
+// regions, then reads every stored chunk through the stream-based
+// and the memory-mapped region files (when supported by the platform).
+// Built with -DVOXELENGINE_BUILD_BENCHMARKS=ON
+#include "fixture.h"
+#include "files/WorldFiles.h"
+#include "voxels/Chunk.h"
+#include "util/timeutil.h"
+
+#include <cmath>
+#include <memory>
+#include <vector>
+#include <iostream>
+#include <stdexcept>
+
+inline constexpr int REGIONS = 8;
+inline constexpr int AREA_CHUNKS = REGIONS * int(REGION_SIZE);
+/// @brief Number of distinct chunks stored (repeated over the area)
+inline constexpr int PATTERNS = 16;
+inline constexpr int READ_PASSES = 3;
+
+static std::unique_ptr<ubyte[]> encode_pattern(
+    int index, blockid_t stone, blockid_t dirt, size_t& size
+) {
+    auto voxels = std::make_unique<voxel[]>(CHUNK_VOL);
+    for (int y = 0; y < CHUNK_H; y++) {
+        for (int z = 0; z < CHUNK_D; z++) {
+            for (int x = 0; x < CHUNK_W; x++) {
+                int height = 64 + int(10 * std::sin((x + index * 7) * 0.3) +
+                                      10 * std::cos((z + index * 3) * 0.2));
+                blockid_t id = y < height - 3 ? stone : (y < height ? dirt : 0);
+                voxels[vox_index(x, y, z)] = voxel {id, 0};
+            }
+        }
+    }
+    return std::unique_ptr<ubyte[]>(Chunk::encode(voxels.get(), size));
+}
+
+/// @brief Read all area chunks with a new WorldFiles instance
+/// @param hash (out argument) hash of the chunks data read
+/// @return time spent (microseconds)
+static int64_t read_area(const fs::path& folder, bool mapped, uint64_t& hash) {
+    DebugSettings settings;
+    settings.mmapRegions = mapped;
+    settings.regionsReadAhead = false;
+    WorldFiles wfile(folder, settings);
+
+    hash = fixture::HASH_OFFSET;
+    timeutil::Timer timer;
+    for (int z = 0; z < AREA_CHUNKS; z++) {
+        for (int x = 0; x < AREA_CHUNKS; x++) {
+            size_t size;
+            std::unique_ptr<ubyte[]> data (wfile.getChunk(x, z, size));
+            if (data == nullptr) {
+                throw std::runtime_error("chunk is missing");
+            }
+            fixture::hash_combine(hash, size);
+            fixture::hash_combine(hash, data[size / 2]);
+        }
+    }
+    return timer.stop();
+}
+
+static void report(const char* name, const fs::path& folder, bool mapped) {
+    for (int pass = 0; pass < READ_PASSES; pass++) {
+        uint64_t hash;
+        int64_t time = read_area(folder, mapped, hash);
+        std::cout << name << " read " << AREA_CHUNKS * AREA_CHUNKS
+                  << " chunks: " << time / 1000 << " ms ("
+                  << double(time) / (AREA_CHUNKS * AREA_CHUNKS)
+                  << " us per chunk), hash: " << std::hex << hash
+                  << std::dec << std::endl;
+    }
+}
+
+int main() {
+    std::unique_ptr<Content> content (fixture::build_content(
+        [](ContentBuilder& builder) {
+            fixture::create_block(builder, "bench:stone");
+            fixture::create_block(builder, "bench:dirt");
+        }
+    ));
+    blockid_t stone = content->requireBlock("bench:stone").rt.id;
+    blockid_t dirt = content->requireBlock("bench:dirt").rt.id;
+
+    fs::path folder = fs::temp_directory_path() / fs::path("voxelengine_regions_bench");
+    fs::remove_all(folder);
+    {
+        std::vector<std::unique_ptr<ubyte[]>> patterns;
+        std::vector<size_t> sizes(PATTERNS);
+        for (int i = 0; i < PATTERNS; i++) {
+            patterns.push_back(encode_pattern(i, stone, dirt, sizes[i]));
+        }
+        DebugSettings settings;
+        WorldFiles wfile(folder, settings);
+        wfile.createDirectories();
+        timeutil::Timer writeTimer;
+        for (int z = 0; z < AREA_CHUNKS; z++) {
+            for (int x = 0; x < AREA_CHUNKS; x++) {
+                int pattern = (x * 5 + z * 3) % PATTERNS;
+                wfile.put(x, z, patterns[pattern].get(), sizes[pattern]);
+            }
+        }
+        wfile.write(nullptr, content.get());
+        std::cout << "write " << REGIONS * REGIONS << " regions: "
+                  << writeTimer.stop() / 1000 << " ms" << std::endl;
+    }
+
+    report("stream", folder, false);
+    if (files::mmfile::supported()) {
+        report("mmap", folder, true);
+    } else {
+        std::cout << "mmap is not supported" << std::endl;
+    }
+    fs::remove_all(folder);
+    return 0;
+}
@@ -25,6 +25,13 @@ inline constexpr int ITEM_ICON_SIZE = 48;
 /* Chunk volume (count of voxels per Chunk) */
 inline constexpr int CHUNK_VOL = (CHUNK_W * CHUNK_H * CHUNK_D);
 
+/* Height of chunk vertical section (sections filled with a single 
+   voxel or light value are not allocated) */
+inline constexpr int CHUNK_SECTION_H = 28;
+inline constexpr int CHUNK_SECTIONS = CHUNK_H / CHUNK_SECTION_H;
+inline constexpr int CHUNK_SECTION_VOL = (CHUNK_W * CHUNK_SECTION_H * CHUNK_D);
+static_assert(CHUNK_H % CHUNK_SECTION_H == 0, "CHUNK_H must be divisible by CHUNK_SECTION_H");
+
 /* BLOCK_VOID is block id used to mark non-existing voxel (voxel of missing chunk) */
 inline constexpr blockid_t BLOCK_VOID = std::numeric_limits<blockid_t>::max();
 inline constexpr itemid_t ITEM_VOID = std::numeric_limits<itemid_t>::max();
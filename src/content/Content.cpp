@@ -138,7 +138,18 @@ ContentIndices::ContentIndices(
     std::vector<ItemDef*> itemDefs
 ) : blockDefs(blockDefs), 
     itemDefs(itemDefs) 
-{}
+{
+    auto& props = blockProps;
+    for (const Block* def : blockDefs) {
+        props.lightPassing.push_back(def->lightPassing);
+        props.skyLightPassing.push_back(def->skyLightPassing);
+        props.obstacle.push_back(def->obstacle);
+        props.solid.push_back(def->rt.solid);
+        props.emissive.push_back(def->rt.emissive);
+        props.drawGroup.push_back(def->drawGroup);
+        props.model.push_back(def->model);
+    }
+}
 
 Content::Content(
     ContentIndices* indices, 
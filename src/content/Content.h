@@ -68,10 +68,23 @@ public:
     Content* build();
 };
 
+/// @brief Block properties checked in hot loops (lighting, meshing,
+/// physics) as id-indexed arrays, so a check does not load whole Block
+struct block_props {
+    std::vector<ubyte> lightPassing;
+    std::vector<ubyte> skyLightPassing;
+    std::vector<ubyte> obstacle;
+    std::vector<ubyte> solid;
+    std::vector<ubyte> emissive;
+    std::vector<ubyte> drawGroup;
+    std::vector<BlockModel> model;
+};
+
 /// @brief Runtime defs cache: indices
 class ContentIndices {
     std::vector<Block*> blockDefs;
     std::vector<ItemDef*> itemDefs;
+    block_props blockProps;
 public:
     ContentIndices(
         std::vector<Block*> blockDefs, 
@@ -106,6 +119,11 @@ public:
     const ItemDef* const* getItemDefs() const {
         return itemDefs.data();
     }
+
+    /// @brief Block properties tables (no range check)
+    const block_props& getBlockProps() const {
+        return blockProps;
+    }
 };
 
 /* Content is a definitions repository */
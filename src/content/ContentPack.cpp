@@ -15,6 +15,7 @@ const std::string ContentPack::PACKAGE_FILENAME = "package.json";
 const std::string ContentPack::CONTENT_FILENAME = "content.json";
 const fs::path ContentPack::BLOCKS_FOLDER = "blocks";
 const fs::path ContentPack::ITEMS_FOLDER = "items";
+const fs::path ContentPack::GENERATORS_FOLDER = "generators";
 const std::vector<std::string> ContentPack::RESERVED_NAMES = {
     "res", "abs", "local", "core", "user", "world", "none", "null"
 };
@@ -41,6 +41,7 @@ struct ContentPack {
     static const std::string CONTENT_FILENAME;
     static const fs::path BLOCKS_FOLDER;
     static const fs::path ITEMS_FOLDER;
+    static const fs::path GENERATORS_FOLDER;
     static const fs::path SHADERS_FOLDER;
     static const std::vector<std::string> RESERVED_NAMES;
 
@@ -15,12 +15,6 @@
 #include "assets/Assets.h"
 #include "assets/AssetsLoader.h"
 #include "world/WorldGenerators.h"
-#include "voxels/DefaultWorldGenerator.h"
-#include "voxels/FlatWorldGenerator.h"
-#include "voxels/CubicWorldGenerator.h"
-#include "voxels/DebrisWorldGenerator.h"
-#include "voxels/TropicalWorldGenerator.h"
-#include "voxels/SpaceWorldGenerator.h"
 #include "window/Window.h"
 #include "window/Events.h"
 #include "window/Camera.h"
@@ -50,15 +44,6 @@
 
 namespace fs = std::filesystem;
 
-void addWorldGenerators() {
-    WorldGenerators::addGenerator<DefaultWorldGenerator>("core:default");
-    WorldGenerators::addGenerator<FlatWorldGenerator>("core:flat");
-    WorldGenerators::addGenerator<DebrisWorldGenerator>("core:debris");
-    WorldGenerators::addGenerator<CubicWorldGenerator>("core:cubic");
-    WorldGenerators::addGenerator<SpaceWorldGenerator>("core:space");
-//    WorldGenerators::addGenerator<TropicalWorldGenerator>("core:tropical");
-}
-
 Engine::Engine(EngineSettings& settings, EnginePaths* paths) 
     : settings(settings), paths(paths) 
 {    
@@ -100,7 +85,7 @@ Engine::Engine(EngineSettings& settings, EnginePaths* paths)
         menus::create_version_label(this);
     }
     setLanguage(settings.ui.language);
-    addWorldGenerators();
+    WorldGenerators::addDefaultGenerators(paths);
 }
 
 void Engine::updateTimers() {
@@ -27,9 +27,27 @@ WorldConverter::WorldConverter(
         std::cerr << "nothing to convert" << std::endl;
         return;
     }
-    tasks.push(convert_task {convert_task_type::player, wfile->getPlayerFile()});
-    for (auto file : fs::directory_iterator(regionsFolder)) {
-        tasks.push(convert_task {convert_task_type::region, file.path()});
+    if (lut) {
+        tasks.push(convert_task {convert_task_type::player, wfile->getPlayerFile()});
+        addRegionTasks(regionsFolder, convert_task_type::region, REGION_LAYER_VOXELS);
+    } else {
+        addRegionTasks(regionsFolder, convert_task_type::upgrade, REGION_LAYER_VOXELS);
+    }
+    // lights and inventories are rewritten in the current region format
+    addRegionTasks(wfile->getLightsFolder(), convert_task_type::upgrade, REGION_LAYER_LIGHTS);
+    addRegionTasks(wfile->getInventoriesFolder(), convert_task_type::upgrade, REGION_LAYER_INVENTORIES);
+}
+
+void WorldConverter::addRegionTasks(fs::path folder, convert_task_type type, int layer) {
+    if (!fs::is_directory(folder)) {
+        return;
+    }
+    for (auto file : fs::directory_iterator(folder)) {
+        // table and temporary files are not regions
+        if (file.path().extension() != ".bin") {
+            continue;
+        }
+        tasks.push(convert_task {type, file.path(), layer});
     }
 }
 
@@ -53,17 +71,29 @@ void WorldConverter::convertRegion(fs::path file) {
         for (uint cx = 0; cx < REGION_SIZE; cx++) {
             int gx = cx + x * REGION_SIZE;
             int gz = cz + z * REGION_SIZE;
-            std::unique_ptr<ubyte[]> data (wfile->getChunk(gx, gz));
+            size_t size;
+            std::unique_ptr<ubyte[]> data (wfile->getChunk(gx, gz, size));
             if (data == nullptr)
                 continue;
-            if (lut) {
-                Chunk::convert(data.get(), lut.get());
+            if (lut && !Chunk::convert(data.get(), size, lut.get())) {
+                std::cerr << "invalid chunk data " << gx << " " << gz << std::endl;
+                continue;
             }
-            wfile->put(gx, gz, data.get());
+            wfile->put(gx, gz, data.get(), size);
         }
     }
 }
 
+void WorldConverter::upgradeRegion(fs::path file, int layer) {
+    int x, z;
+    std::string name = file.stem().string();
+    if (!WorldFiles::parseRegionFilename(name, x, z)) {
+        std::cerr << "could not parse name " << name << std::endl;
+        return;
+    }
+    wfile->upgradeRegion(x, z, layer);
+}
+
 void WorldConverter::convertPlayer(fs::path file) {
     std::cout << "converting player " << file.u8string() << std::endl;
     auto map = files::read_json(file);
@@ -84,6 +114,9 @@ void WorldConverter::convertNext() {
         case convert_task_type::region:
             convertRegion(task.file);
             break;
+        case convert_task_type::upgrade:
+            upgradeRegion(task.file, task.layer);
+            break;
         case convert_task_type::player:
             convertPlayer(task.file);
             break;
@@ -93,6 +126,7 @@ void WorldConverter::convertNext() {
 void WorldConverter::write() {
     std::cout << "writing world" << std::endl;
     wfile->write(nullptr, content);
+    wfile->writeRegionsVersion();
 }
 
 uint WorldConverter::getTotalTasks() const {
@@ -13,12 +13,14 @@ class ContentLUT;
 class WorldFiles;
 
 enum class convert_task_type {
-    region, player
+    region, upgrade, player
 };
 
 struct convert_task {
     convert_task_type type;
     fs::path file;
+    /// @brief region layer (used by upgrade tasks)
+    int layer = 0;
 };
 
 class WorldConverter {
@@ -29,7 +31,11 @@ class WorldConverter {
 
     void convertPlayer(fs::path file);
     void convertRegion(fs::path file);
+    void upgradeRegion(fs::path file, int layer);
+    void addRegionTasks(fs::path folder, convert_task_type type, int layer);
 public:
+    /// @param lut content indices conversion table or nullptr
+    /// if only region files format upgrade is required
     WorldConverter(fs::path folder, const Content* content, 
                    std::shared_ptr<ContentLUT> lut);
     ~WorldConverter();
@@ -28,17 +28,21 @@
 #include <fstream>
 #include <sstream>
 #include <cstring>
+#include <algorithm>
 
 #define REGION_FORMAT_MAGIC ".VOXREG"
 #define WORLD_FORMAT_MAGIC ".VOXWLD"
 
-const size_t BUFFER_SIZE_UNKNOWN = -1;
-
-regfile::regfile(fs::path filename) : file(filename) {
-    if (file.length() < REGION_HEADER_SIZE)
+regfile::regfile(fs::path filename, bool mapped) : filename(filename) {
+    if (mapped) {
+        mapping = std::make_unique<files::mmfile>(filename);
+    } else {
+        file = std::make_unique<files::rafile>(filename);
+    }
+    if (length() < REGION_HEADER_SIZE)
         throw std::runtime_error("incomplete region file header");
     char header[REGION_HEADER_SIZE];
-    file.read(header, REGION_HEADER_SIZE);
+    read(0, (ubyte*)header, REGION_HEADER_SIZE);
     
     // avoid of use strcmp_s
     if (std::string(header, strlen(REGION_FORMAT_MAGIC)) != REGION_FORMAT_MAGIC) {
@@ -49,28 +53,139 @@ regfile::regfile(fs::path filename) : file(filename) {
         throw illegal_region_format(
             "region format "+std::to_string(version)+" is not supported");
     }
+    readTable();
+}
+
+void regfile::readTable() {
+    offsets = std::make_unique<uint32_t[]>(REGION_CHUNKS_COUNT);
+    sizes = std::make_unique<uint32_t[]>(REGION_CHUNKS_COUNT);
+    if (version < 3) {
+        // table of offsets in the end of file, size stored before data
+        ubyte table[REGION_CHUNKS_COUNT * 4];
+        if (length() < REGION_HEADER_SIZE + sizeof(table)) {
+            throw illegal_region_format("incomplete region file table");
+        }
+        read(length() - sizeof(table), table, sizeof(table));
+        for (uint i = 0; i < REGION_CHUNKS_COUNT; i++) {
+            offsets[i] = dataio::read_int32_big(table, i * 4);
+        }
+        ubyte bytes[4];
+        for (uint i : getChunksOrder()) {
+            if (size_t(offsets[i]) + 4 > length()) {
+                throw illegal_region_format("chunk offset is out of region file bounds");
+            }
+            read(offsets[i], bytes, 4);
+            sizes[i] = dataio::read_int32_big(bytes, 0);
+            offsets[i] += 4;
+        }
+    } else {
+        ubyte table[REGION_TABLE_SIZE];
+        if (length() < REGION_HEADER_SIZE + sizeof(table)) {
+            throw illegal_region_format("incomplete region file table");
+        }
+        read(REGION_HEADER_SIZE, table, sizeof(table));
+        generation = dataio::read_int32_big(table, 0);
+
+        // table file left from the previous generation is ignored
+        ubyte updated[REGION_TABLE_SIZE];
+        std::ifstream stream(getTableFilename(filename), std::ios::binary);
+        if (stream.read((char*)updated, sizeof(updated)) && 
+            uint32_t(dataio::read_int32_big(updated, 0)) == generation) {
+            std::memcpy(table, updated, sizeof(table));
+        }
+        for (uint i = 0; i < REGION_CHUNKS_COUNT; i++) {
+            size_t pos = 4 + i * REGION_TABLE_ENTRY_SIZE;
+            offsets[i] = dataio::read_int32_big(table, pos);
+            sizes[i] = dataio::read_int32_big(table, pos + 4);
+        }
+    }
+}
+
+fs::path regfile::getTableFilename(const fs::path& filename) {
+    fs::path tableFile = filename;
+    return tableFile.replace_extension(".table");
+}
+
+size_t regfile::length() const {
+    if (mapping) {
+        return mapping->length();
+    }
+    return file->length();
+}
+
+void regfile::read(size_t offset, ubyte* dst, size_t size) {
+    if (mapping) {
+        if (offset + size > mapping->length()) {
+            throw illegal_region_format("region file read out of bounds");
+        }
+        std::memcpy(dst, mapping->getData() + offset, size);
+        return;
+    }
+    file->seekg(offset);
+    file->read((char*)dst, size);
+}
+
+const ubyte* regfile::getMappedData() const {
+    if (mapping) {
+        return mapping->getData();
+    }
+    return nullptr;
+}
+
+bool regfile::findChunk(uint index, uint32_t& offset, uint32_t& size) const {
+    offset = offsets[index];
+    size = sizes[index];
+    if (offset == 0) {
+        return false;
+    }
+    if (size_t(offset) + size > length()) {
+        throw illegal_region_format("chunk data is out of region file bounds");
+    }
+    return true;
+}
+
+std::vector<uint> regfile::getChunksOrder() const {
+    std::vector<uint> order;
+    for (uint i = 0; i < REGION_CHUNKS_COUNT; i++) {
+        if (offsets[i]) {
+            order.push_back(i);
+        }
+    }
+    std::sort(order.begin(), order.end(), [this](uint a, uint b) {
+        return offsets[a] < offsets[b];
+    });
+    return order;
 }
 
 WorldRegion::WorldRegion() {
     chunksData = new ubyte*[REGION_CHUNKS_COUNT]{};
     sizes = new uint32_t[REGION_CHUNKS_COUNT]{};
+    unsavedChunks = new bool[REGION_CHUNKS_COUNT]{};
 }
 
 WorldRegion::~WorldRegion() {
     for (uint i = 0; i < REGION_CHUNKS_COUNT; i++) {
         delete[] chunksData[i];
     }
+    delete[] unsavedChunks;
     delete[] sizes;
     delete[] chunksData;
 }
 
 void WorldRegion::setUnsaved(bool unsaved) {
     this->unsaved = unsaved;
+    if (!unsaved) {
+        std::fill_n(unsavedChunks, REGION_CHUNKS_COUNT, false);
+    }
 }
 bool WorldRegion::isUnsaved() const {
     return unsaved;
 }
 
+bool WorldRegion::isChunkUnsaved(uint index) const {
+    return unsavedChunks[index];
+}
+
 ubyte** WorldRegion::getChunks() const {
     return chunksData;
 }
@@ -79,17 +194,29 @@ uint32_t* WorldRegion::getSizes() const {
     return sizes;
 }
 
-void WorldRegion::put(uint x, uint z, ubyte* data, uint32_t size) {
+void WorldRegion::put(uint x, uint z, ubyte* data, uint32_t size, bool unsaved) {
     size_t chunk_index = z * REGION_SIZE + x;
+    if (chunksData[chunk_index]) {
+        dataSize -= sizes[chunk_index];
+    }
     delete[] chunksData[chunk_index];
     chunksData[chunk_index] = data;
-    sizes[chunk_index] = size;
+    sizes[chunk_index] = data ? size : 0;
+    dataSize += sizes[chunk_index];
+    if (unsaved) {
+        unsavedChunks[chunk_index] = true;
+        this->unsaved = true;
+    }
 }
 
 ubyte* WorldRegion::getChunkData(uint x, uint z) {
     return chunksData[z * REGION_SIZE + x];
 }
 
+size_t WorldRegion::getDataSize() const {
+    return dataSize;
+}
+
 uint WorldRegion::getChunkDataSize(uint x, uint z) {
     return sizes[z * REGION_SIZE + x];
 }
@@ -97,12 +224,19 @@ uint WorldRegion::getChunkDataSize(uint x, uint z) {
 WorldFiles::WorldFiles(fs::path directory, const DebugSettings& settings) 
   : directory(directory), 
     generatorTestMode(settings.generatorTestMode),
-    doWriteLights(settings.doWriteLights) 
+    doWriteLights(settings.doWriteLights),
+    doWriteFullLights(settings.doWriteFullLights),
+    mmapRegions(settings.mmapRegions && files::mmfile::supported()),
+    regionsReadAhead(settings.regionsReadAhead)
 {
-    compressionBuffer = std::make_unique<ubyte[]>(CHUNK_DATA_LEN * 2);
+    regFilesLimit = std::max(settings.regionFilesLimit, 1U);
+    regionsCacheLimit = size_t(settings.regionsCacheLimit) * 1024 * 1024;
+    compressionBuffer = std::make_unique<ubyte[]>(CHUNK_ENCODED_MAX_LEN * 2);
 }
 
 WorldFiles::~WorldFiles() {
+    // loader threads use regions maps
+    loader.reset();
 }
 
 void WorldFiles::createDirectories() {
@@ -114,6 +248,7 @@ WorldRegion* WorldFiles::getRegion(regionsmap& regions, int x, int z) {
     auto found = regions.find(glm::ivec2(x, z));
     if (found == regions.end())
         return nullptr;
+    found->second->lastAccess = ++regionsAccessCounter;
     return found->second.get();
 }
 
@@ -121,6 +256,7 @@ WorldRegion* WorldFiles::getOrCreateRegion(regionsmap& regions, int x, int z) {
     WorldRegion* region = getRegion(regions, x, z);
     if (region == nullptr) {
         region = new WorldRegion();
+        region->lastAccess = ++regionsAccessCounter;
         regions[glm::ivec2(x, z)].reset(region);
     }
     return region;
@@ -144,7 +280,8 @@ ubyte* WorldFiles::decompress(const ubyte* src, size_t srclen, size_t dstlen) {
 }
 
 int WorldFiles::getVoxelRegionVersion(int x, int z) {
-    regfile* rf = getRegFile(glm::ivec3(x, z, REGION_LAYER_VOXELS), getRegionsFolder());
+    std::lock_guard<std::mutex> lock(regionsMutex);
+    auto rf = getRegFile(glm::ivec3(x, z, REGION_LAYER_VOXELS), getRegionsFolder());
     if (rf == nullptr) {
         return 0;
     }
@@ -152,38 +289,56 @@ int WorldFiles::getVoxelRegionVersion(int x, int z) {
 }
 
 int WorldFiles::getVoxelRegionsVersion() {
-    fs::path regionsFolder = getRegionsFolder();
-    if (!fs::is_directory(regionsFolder)) {
+    fs::path file = getWorldFile();
+    if (!fs::is_regular_file(file)) {
         return REGION_FORMAT_VERSION;
     }
-    for (auto file : fs::directory_iterator(regionsFolder)) {
-        int x;
-        int z;
-        if (!parseRegionFilename(file.path().stem().string(), x, z)) {
-            continue;
-        }
-        regfile* rf = getRegFile(glm::ivec3(x, z, REGION_LAYER_VOXELS), regionsFolder);
-        return rf->version;
+    // not stored by versions before 3
+    return files::read_json(file)->getInt("region-format", 0);
+}
+
+void WorldFiles::writeRegionsVersion() {
+    fs::path file = getWorldFile();
+    if (!fs::is_regular_file(file)) {
+        return;
+    }
+    auto root = files::read_json(file);
+    root->put("region-format", REGION_FORMAT_VERSION);
+    files::write_json(file, root.get());
+}
+
+void WorldFiles::upgradeRegion(int x, int z, int layer) {
+    std::lock_guard<std::mutex> lock(regionsMutex);
+    switch (layer) {
+        case REGION_LAYER_VOXELS:
+            getOrCreateRegion(regions, x, z)->setUnsaved(true);
+            break;
+        case REGION_LAYER_LIGHTS:
+            getOrCreateRegion(lights, x, z)->setUnsaved(true);
+            break;
+        case REGION_LAYER_INVENTORIES:
+            getOrCreateRegion(storages, x, z)->setUnsaved(true);
+            break;
     }
-    return REGION_FORMAT_VERSION;
 }
 
 
 /// @brief Compress and store chunk voxels data in region 
 /// @param x chunk.x
 /// @param z chunk.z
-void WorldFiles::put(int x, int z, const ubyte* voxelData) {
+void WorldFiles::put(int x, int z, const ubyte* voxelData, size_t size) {
     int regionX = floordiv(x, REGION_SIZE);
     int regionZ = floordiv(z, REGION_SIZE);
     int localX = x - (regionX * REGION_SIZE);
     int localZ = z - (regionZ * REGION_SIZE);
 
     /* Writing Voxels */ {
-        WorldRegion* region = getOrCreateRegion(regions, regionX, regionZ);
-        region->setUnsaved(true);
         size_t compressedSize;
-        ubyte* data = compress(voxelData, CHUNK_DATA_LEN, compressedSize);
-        region->put(localX, localZ, data, compressedSize);
+        ubyte* data = compress(voxelData, size, compressedSize);
+
+        std::lock_guard<std::mutex> lock(regionsMutex);
+        WorldRegion* region = getOrCreateRegion(regions, regionX, regionZ);
+        region->put(localX, localZ, data, compressedSize, true);
     }
 }
 
@@ -197,23 +352,30 @@ void WorldFiles::put(Chunk* chunk){
     int localZ = chunk->z - (regionZ * REGION_SIZE);
 
     /* Writing voxels */ {
+        size_t encodedSize;
         size_t compressedSize;
-        std::unique_ptr<ubyte[]> chunk_data (chunk->encode());
-        ubyte* data = compress(chunk_data.get(), CHUNK_DATA_LEN, compressedSize);
+        std::unique_ptr<ubyte[]> chunk_data (chunk->encode(encodedSize));
+        ubyte* data = compress(chunk_data.get(), encodedSize, compressedSize);
 
+        std::lock_guard<std::mutex> lock(regionsMutex);
         WorldRegion* region = getOrCreateRegion(regions, regionX, regionZ);
-        region->setUnsaved(true);
-        region->put(localX, localZ, data, compressedSize);
+        region->put(localX, localZ, data, compressedSize, true);
     }
     // Writing lights cache
     if (doWriteLights && chunk->isLighted()) {
         size_t compressedSize;
-        std::unique_ptr<ubyte[]> light_data (chunk->lightmap.encode());
-        ubyte* data = compress(light_data.get(), LIGHTMAP_DATA_LEN, compressedSize);
+        ubyte* data;
+        if (doWriteFullLights) {
+            std::unique_ptr<ubyte[]> light_data (chunk->lightmap.encodeFull());
+            data = compress(light_data.get(), LIGHTMAP_FULL_DATA_LEN, compressedSize);
+        } else {
+            std::unique_ptr<ubyte[]> light_data (chunk->lightmap.encode());
+            data = compress(light_data.get(), LIGHTMAP_DATA_LEN, compressedSize);
+        }
 
+        std::lock_guard<std::mutex> lock(regionsMutex);
         WorldRegion* region = getOrCreateRegion(lights, regionX, regionZ);
-        region->setUnsaved(true);
-        region->put(localX, localZ, data, compressedSize);
+        region->put(localX, localZ, data, compressedSize, true);
     }
     // Writing block inventories
     if (!chunk->inventories.empty()){
@@ -226,17 +388,17 @@ void WorldFiles::put(Chunk* chunk){
             auto bytes = json::to_binary(map.get(), true);
             builder.putInt32(bytes.size());
             builder.put(bytes.data(), bytes.size());
-        }   
-        WorldRegion* region = getOrCreateRegion(storages, regionX, regionZ);
-        region->setUnsaved(true);
-
+        }
         auto datavec = builder.data();
         uint datasize = builder.size();
         auto data = std::make_unique<ubyte[]>(datasize);
         for (uint i = 0; i < datasize; i++) {
             data[i] = datavec[i];
         }
-        region->put(localX, localZ, data.release(), datasize);
+
+        std::lock_guard<std::mutex> lock(regionsMutex);
+        WorldRegion* region = getOrCreateRegion(storages, regionX, regionZ);
+        region->put(localX, localZ, data.release(), datasize, true);
     }
 }
 
@@ -292,25 +454,78 @@ fs::path WorldFiles::getPacksFile() const {
     return directory/fs::path("packs.list");
 }
 
-ubyte* WorldFiles::getChunk(int x, int z){
-    return getData(regions, getRegionsFolder(), x, z, REGION_LAYER_VOXELS, true);
+ubyte* WorldFiles::getChunk(int x, int z, size_t& size){
+    uint32_t compressedSize;
+    std::shared_ptr<const ubyte> data;
+    {
+        std::lock_guard<std::mutex> lock(regionsMutex);
+        data = getData(regions, getRegionsFolder(), x, z, REGION_LAYER_VOXELS, compressedSize);
+    }
+    if (data == nullptr)
+        return nullptr;
+    ubyte* decompressed = new ubyte[CHUNK_ENCODED_MAX_LEN];
+    size = extrle::decode(data.get(), compressedSize, decompressed);
+    return decompressed;
 }
 
-/// @brief Get cached lights for chunk at x,z 
-/// @return lights data or nullptr
-light_t* WorldFiles::getLights(int x, int z) {
-    std::unique_ptr<ubyte[]> data (getData(lights, getLightsFolder(), x, z, REGION_LAYER_LIGHTS, true));
+light_t* WorldFiles::getLights(int x, int z, bool& full) {
+    uint32_t size;
+    std::shared_ptr<const ubyte> data;
+    {
+        std::lock_guard<std::mutex> lock(regionsMutex);
+        data = getData(lights, getLightsFolder(), x, z, REGION_LAYER_LIGHTS, size);
+    }
     if (data == nullptr)
         return nullptr;
-    return Lightmap::decode(data.get());
+    auto lightsData = std::make_unique<ubyte[]>(CHUNK_DATA_LEN);
+    size_t length = extrle::decode(data.get(), size, lightsData.get());
+    // sky light data is stored with no format byte
+    full = length != LIGHTMAP_DATA_LEN;
+    if (!full) {
+        return Lightmap::decode(lightsData.get());
+    }
+    if (length != LIGHTMAP_FULL_DATA_LEN) {
+        return nullptr;
+    }
+    return Lightmap::decodeFull(lightsData.get());
+}
+
+void WorldFiles::invalidateFullLights(int x, int z) {
+    if (!staleLights.insert(glm::ivec2(x, z)).second) {
+        return;
+    }
+    bool full;
+    std::unique_ptr<light_t[]> cache (getLights(x, z, full));
+    if (cache == nullptr || !full) {
+        return;
+    }
+    Lightmap lightmap;
+    lightmap.set(cache.get());
+    std::unique_ptr<ubyte[]> light_data (lightmap.encode());
+    size_t compressedSize;
+    ubyte* data = compress(light_data.get(), LIGHTMAP_DATA_LEN, compressedSize);
+
+    int regionX = floordiv(x, REGION_SIZE);
+    int regionZ = floordiv(z, REGION_SIZE);
+    std::lock_guard<std::mutex> lock(regionsMutex);
+    WorldRegion* region = getOrCreateRegion(lights, regionX, regionZ);
+    region->put(
+        x - regionX * REGION_SIZE, z - regionZ * REGION_SIZE, 
+        data, compressedSize, true
+    );
 }
 
 chunk_inventories_map WorldFiles::fetchInventories(int x, int z) {
     chunk_inventories_map inventories;
-    const ubyte* data = getData(storages, getInventoriesFolder(), x, z, REGION_LAYER_INVENTORIES, false);
+    uint32_t size;
+    std::shared_ptr<const ubyte> data;
+    {
+        std::lock_guard<std::mutex> lock(regionsMutex);
+        data = getData(storages, getInventoriesFolder(), x, z, REGION_LAYER_INVENTORIES, size);
+    }
     if (data == nullptr)
         return inventories;
-    ByteReader reader(data, BUFFER_SIZE_UNKNOWN);
+    ByteReader reader(data.get(), size);
     int count = reader.getInt32();
     for (int i = 0; i < count; i++) {
         uint index = reader.getInt32();
@@ -324,8 +539,107 @@ chunk_inventories_map WorldFiles::fetchInventories(int x, int z) {
     return inventories;
 }
 
-ubyte* WorldFiles::getData(regionsmap& regions, const fs::path& folder, 
-                           int x, int z, int layer, bool compression) {
+loaded_chunk WorldFiles::loadChunk(int x, int z) {
+    loaded_chunk chunk;
+    chunk.x = x;
+    chunk.z = z;
+    chunk.voxels.reset(getChunk(x, z, chunk.voxelsSize));
+    if (chunk.voxels) {
+        chunk.inventories = fetchInventories(x, z);
+    }
+    chunk.lights.reset(getLights(x, z, chunk.fullLights));
+    return chunk;
+}
+
+chunks_loader& WorldFiles::getLoader() {
+    if (loader == nullptr) {
+        uint threads = std::thread::hardware_concurrency() / 2;
+        loader = std::make_unique<chunks_loader>(
+            "chunks loading",
+            [this](chunk_load_job& job) {
+                if (job.prefetch) {
+                    prefetchChunk(job.pos.x, job.pos.y);
+                    loaded_chunk result;
+                    result.prefetched = true;
+                    return result;
+                }
+                return loadChunk(job.pos.x, job.pos.y);
+            },
+            std::min(threads, MAX_CHUNK_LOADER_THREADS)
+        );
+    }
+    return *loader;
+}
+
+void WorldFiles::requestChunk(int x, int z) {
+    glm::ivec2 key(x, z);
+    if (!requestedChunks.insert(key).second) {
+        return;
+    }
+    getLoader().enqueueJob(chunk_load_job {key, false});
+}
+
+void WorldFiles::cancelChunk(int x, int z) {
+    glm::ivec2 key(x, z);
+    if (requestedChunks.erase(key) && loader) {
+        loader->removeJobs([=](const chunk_load_job& job) {
+            return !job.prefetch && job.pos == key;
+        });
+    }
+}
+
+void WorldFiles::cancelChunksOutside(int x, int z, int w, int d) {
+    auto outside = [=](const glm::ivec2& pos) {
+        return pos.x < x || pos.y < z || pos.x >= x + w || pos.y >= z + d;
+    };
+    for (auto it = requestedChunks.begin(); it != requestedChunks.end();) {
+        if (outside(*it)) {
+            it = requestedChunks.erase(it);
+        } else {
+            it++;
+        }
+    }
+    if (loader) {
+        loader->removeJobs([=](const chunk_load_job& job) {
+            return !job.prefetch && outside(job.pos);
+        });
+    }
+}
+
+bool WorldFiles::isChunkRequested(int x, int z) const {
+    return requestedChunks.find(glm::ivec2(x, z)) != requestedChunks.end();
+}
+
+size_t WorldFiles::countRequestedChunks() const {
+    return requestedChunks.size();
+}
+
+bool WorldFiles::pollChunk(loaded_chunk& dst) {
+    if (loader == nullptr) {
+        return false;
+    }
+    while (loader->pollResult(dst)) {
+        // results of cancelled requests are dropped
+        glm::ivec2 pos (dst.x, dst.z);
+        if (dst.prefetched || !requestedChunks.erase(pos)) {
+            continue;
+        }
+        // full cache read before it was invalidated
+        if (staleLights.erase(pos) && dst.fullLights) {
+            for (uint i = 0; i < CHUNK_VOL; i++) {
+                dst.lights[i] &= Lightmap::combine(0, 0, 0, 0xF);
+            }
+            dst.fullLights = false;
+        }
+        return true;
+    }
+    return false;
+}
+
+std::shared_ptr<const ubyte> WorldFiles::getData(
+    regionsmap& regions, const fs::path& folder, 
+    int x, int z, int layer, uint32_t& size
+) {
     int regionX = floordiv(x, REGION_SIZE);
     int regionZ = floordiv(z, REGION_SIZE);
 
@@ -334,40 +648,189 @@ ubyte* WorldFiles::getData(regionsmap& regions, const fs::path& folder,
 
     WorldRegion* region = getOrCreateRegion(regions, regionX, regionZ);
     ubyte* data = region->getChunkData(localX, localZ);
-    if (data == nullptr) {
-        uint32_t size;
-        data = readChunkData(x, z, size, folder, layer);
-        if (data != nullptr) {
-            region->put(localX, localZ, data, size);
+    if (data == nullptr && !generatorTestMode) {
+        auto rfile = getRegFile(glm::ivec3(regionX, regionZ, layer), folder);
+        if (rfile == nullptr) {
+            return nullptr;
+        }
+        uint index = localZ * REGION_SIZE + localX;
+        const ubyte* mapped = rfile->getMappedData();
+        bool legacy = layer == REGION_LAYER_VOXELS && 
+            uint(rfile->version) < REGION_ENCODED_VOXELS_VERSION;
+        if (mapped && !legacy) {
+            // no copy: pointer shares ownership of the region file
+            uint32_t offset;
+            if (!rfile->findChunk(index, offset, size)) {
+                return nullptr;
+            }
+            return std::shared_ptr<const ubyte>(rfile, mapped + offset);
         }
+        data = readChunk(*rfile, index, layer, size);
+        if (data == nullptr) {
+            return nullptr;
+        }
+        region->put(localX, localZ, data, size, false);
+    }
+    if (data == nullptr) {
+        return nullptr;
     }
-    if (data != nullptr) {
-        size_t size = region->getChunkDataSize(localX, localZ);
-        if (compression) {
-            return decompress(data, size, CHUNK_DATA_LEN);
+    size = region->getChunkDataSize(localX, localZ);
+    ubyte* copy = new ubyte[size];
+    std::memcpy(copy, data, size);
+    return std::shared_ptr<const ubyte>(copy, std::default_delete<ubyte[]>());
+}
+
+void WorldFiles::prefetchData(
+    regionsmap& regions, const fs::path& folder, int x, int z, int layer
+) {
+    int regionX = floordiv(x, REGION_SIZE);
+    int regionZ = floordiv(z, REGION_SIZE);
+    int localX = x - (regionX * REGION_SIZE);
+    int localZ = z - (regionZ * REGION_SIZE);
+
+    WorldRegion* region = getOrCreateRegion(regions, regionX, regionZ);
+    if (region->getChunkData(localX, localZ)) {
+        return;
+    }
+    uint32_t size;
+    if (ubyte* data = readChunkData(x, z, size, folder, layer)) {
+        region->put(localX, localZ, data, size, false);
+    }
+}
+
+void WorldFiles::prefetchChunk(int x, int z) {
+    std::lock_guard<std::mutex> lock(regionsMutex);
+    prefetchData(regions, getRegionsFolder(), x, z, REGION_LAYER_VOXELS);
+    prefetchData(lights, getLightsFolder(), x, z, REGION_LAYER_LIGHTS);
+    prefetchData(storages, getInventoriesFolder(), x, z, REGION_LAYER_INVENTORIES);
+}
+
+void WorldFiles::prefetchChunks(int x, int z, int w, int d) {
+    // memory-mapped data is read without copying to the regions cache
+    if (generatorTestMode || mmapRegions || !regionsReadAhead) {
+        return;
+    }
+    auto& loader = getLoader();
+    for (int cz = z; cz < z + d; cz++) {
+        for (int cx = x; cx < x + w; cx++) {
+            // requested chunks are read before
+            loader.enqueueJob(chunk_load_job {glm::ivec2(cx, cz), true}, true);
         }
-        return data;
     }
-    return nullptr;
 }
 
+void WorldFiles::cancelPrefetch() {
+    if (loader) {
+        loader->removeJobs([](const chunk_load_job& job) {
+            return job.prefetch;
+        });
+    }
+}
 
-regfile* WorldFiles::getRegFile(glm::ivec3 coord, const fs::path& folder) {
+std::shared_ptr<regfile> WorldFiles::getRegFile(glm::ivec3 coord, const fs::path& folder) {
     const auto found = openRegFiles.find(coord);
     if (found != openRegFiles.end()) {
-        return found->second.get();
-    }
-    if (openRegFiles.size() == MAX_OPEN_REGION_FILES) {
-        // [todo] replace with closing the most unused region
-        auto iter = std::next(openRegFiles.begin(), rand() % openRegFiles.size());
-        openRegFiles.erase(iter);
+        regFilesHits++;
+        auto& entry = found->second;
+        regFilesUsage.splice(regFilesUsage.begin(), regFilesUsage, entry.usage);
+        return entry.file;
     }
+    regFilesMisses++;
     fs::path filename = folder / getRegionFilename(coord[0], coord[1]);
     if (!fs::is_regular_file(filename)) {
         return nullptr;
     }
-    openRegFiles[coord] = std::make_unique<regfile>(filename);
-    return openRegFiles[coord].get();
+    auto file = std::make_shared<regfile>(filename, mmapRegions);
+    while (openRegFiles.size() >= regFilesLimit) {
+        // closing the least recently used file
+        closeRegFile(regFilesUsage.back());
+    }
+    regFilesUsage.push_front(coord);
+    openRegFiles[coord] = open_regfile {file, regFilesUsage.begin()};
+    return file;
+}
+
+void WorldFiles::closeRegFile(glm::ivec3 coord) {
+    const auto found = openRegFiles.find(coord);
+    if (found == openRegFiles.end()) {
+        return;
+    }
+    regFilesUsage.erase(found->second.usage);
+    openRegFiles.erase(found);
+}
+
+void WorldFiles::trimRegionsCache() {
+    std::lock_guard<std::mutex> lock(regionsMutex);
+    regionsmap* maps[] {&regions, &lights, &storages};
+    size_t total = 0;
+    for (auto map : maps) {
+        for (auto& entry : *map) {
+            total += entry.second->getDataSize();
+        }
+    }
+    if (total > regionsCacheLimit) {
+        struct eviction_candidate {
+            regionsmap* map;
+            glm::ivec2 key;
+            uint64_t lastAccess;
+        };
+        // unsaved regions are kept until the world is written: world
+        // files are changed by the world save only
+        std::vector<eviction_candidate> candidates;
+        for (auto map : maps) {
+            for (auto& [key, region] : *map) {
+                if (!region->isUnsaved() && region->lastAccess <= lastTrimAccess) {
+                    candidates.push_back({map, key, region->lastAccess});
+                }
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), 
+            [](const auto& a, const auto& b) {
+                return a.lastAccess < b.lastAccess;
+            }
+        );
+        size_t target = regionsCacheLimit * REGIONS_CACHE_TRIM_TARGET;
+        for (const auto& candidate : candidates) {
+            if (total <= target) {
+                break;
+            }
+            auto found = candidate.map->find(candidate.key);
+            total -= found->second->getDataSize();
+            candidate.map->erase(found);
+        }
+    }
+    lastTrimAccess = regionsAccessCounter;
+}
+
+size_t WorldFiles::getRegionsCacheSize(int layer) {
+    std::lock_guard<std::mutex> lock(regionsMutex);
+    regionsmap* map = nullptr;
+    switch (layer) {
+        case REGION_LAYER_VOXELS: map = &regions; break;
+        case REGION_LAYER_LIGHTS: map = &lights; break;
+        case REGION_LAYER_INVENTORIES: map = &storages; break;
+        default: return 0;
+    }
+    size_t size = 0;
+    for (auto& entry : *map) {
+        size += entry.second->getDataSize();
+    }
+    return size;
+}
+
+size_t WorldFiles::getRegFilesHits() {
+    std::lock_guard<std::mutex> lock(regionsMutex);
+    return regFilesHits;
+}
+
+size_t WorldFiles::getRegFilesMisses() {
+    std::lock_guard<std::mutex> lock(regionsMutex);
+    return regFilesMisses;
+}
+
+size_t WorldFiles::countOpenRegFiles() {
+    std::lock_guard<std::mutex> lock(regionsMutex);
+    return openRegFiles.size();
 }
 
 ubyte* WorldFiles::readChunkData(int x, 
@@ -385,48 +848,171 @@ ubyte* WorldFiles::readChunkData(int x,
     int chunkIndex = localZ * REGION_SIZE + localX;
  
     glm::ivec3 coord(regionX, regionZ, layer);
-    regfile* rfile = WorldFiles::getRegFile(coord, folder);
+    auto rfile = WorldFiles::getRegFile(coord, folder);
     if (rfile == nullptr) {
         return nullptr;
     }
-    files::rafile& file = rfile->file;
 
-    size_t file_size = file.length();
-    size_t table_offset = file_size - REGION_CHUNKS_COUNT * 4;
+    return readChunk(*rfile, chunkIndex, layer, length);
+}
 
+ubyte* WorldFiles::readChunk(regfile& file, uint index, int layer, uint32_t& size) {
     uint32_t offset;
-    file.seekg(table_offset + chunkIndex * 4);
-    file.read((char*)(&offset), 4);
-    offset = dataio::read_int32_big((const ubyte*)(&offset), 0);
-
-    if (offset == 0){
+    if (!file.findChunk(index, offset, size)) {
         return nullptr;
     }
+    ubyte* data = new ubyte[size];
+    file.read(offset, data, size);
+    if (layer == REGION_LAYER_VOXELS && 
+        uint(file.version) < REGION_ENCODED_VOXELS_VERSION) {
+        std::unique_ptr<ubyte[]> legacy (data);
+        return upgradeVoxels(legacy.get(), size, size);
+    }
+    return data;
+}
 
-    file.seekg(offset);
-    file.read((char*)(&offset), 4);
-    length = dataio::read_int32_big((const ubyte*)(&offset), 0);
-    ubyte* data = new ubyte[length]{};
-    file.read((char*)data, length);
+ubyte* WorldFiles::upgradeVoxels(const ubyte* src, size_t srclen, uint32_t& size) {
+    auto plain = std::make_unique<ubyte[]>(CHUNK_DATA_LEN);
+    extrle::decode(src, srclen, plain.get());
+    auto voxels = std::make_unique<voxel[]>(CHUNK_VOL);
+    Chunk::decodeLegacy(plain.get(), voxels.get());
+
+    size_t encodedSize;
+    std::unique_ptr<ubyte[]> encoded (Chunk::encode(voxels.get(), encodedSize));
+    // compressionBuffer is used by the main thread without lock
+    auto buffer = std::make_unique<ubyte[]>(CHUNK_ENCODED_MAX_LEN * 2);
+    size = extrle::encode(encoded.get(), encodedSize, buffer.get());
+    ubyte* data = new ubyte[size];
+    std::memcpy(data, buffer.get(), size);
     return data;
 }
 
 /// @brief Read missing chunks data (null pointers) from region file 
-/// @param layer used as third part of openRegFiles map key 
-/// (see REGION_LAYER_* constants)
 void WorldFiles::fetchChunks(WorldRegion* region, int x, int z, fs::path folder, int layer) {
+    auto rfile = getRegFile(glm::ivec3(x, z, layer), folder);
+    if (rfile == nullptr) {
+        return;
+    }
     ubyte** chunks = region->getChunks();
-    uint32_t* sizes = region->getSizes();
 
-    for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
-        int chunk_x = (i % REGION_SIZE) + x * REGION_SIZE;
-        int chunk_z = (i / REGION_SIZE) + z * REGION_SIZE;
-        if (chunks[i] == nullptr) {
-            chunks[i] = readChunkData(chunk_x, chunk_z, sizes[i], folder, layer);
+    // reading in file order to avoid of seeking back and forth
+    for (uint i : rfile->getChunksOrder()) {
+        if (chunks[i]) {
+            continue;
+        }
+        uint32_t size;
+        if (ubyte* data = readChunk(*rfile, i, layer, size)) {
+            region->put(i % REGION_SIZE, i / REGION_SIZE, data, size, false);
         }
     }
 }
 
+bool WorldFiles::updateRegion(regfile& file, WorldRegion* entry, const fs::path& filename) {
+    const uint dataStart = REGION_HEADER_SIZE + REGION_TABLE_SIZE;
+
+    uint32_t offsets[REGION_CHUNKS_COUNT];
+    uint32_t sizes[REGION_CHUNKS_COUNT];
+    std::copy_n(file.offsets.get(), REGION_CHUNKS_COUNT, offsets);
+    std::copy_n(file.sizes.get(), REGION_CHUNKS_COUNT, sizes);
+
+    ubyte** chunks = entry->getChunks();
+    uint32_t* newSizes = entry->getSizes();
+
+    // free space is everything between spans used by the stored table,
+    // so space of chunks moved by this write is not reused until the 
+    // new table is written
+    std::vector<std::pair<uint32_t, uint32_t>> used;
+    for (uint i = 0; i < REGION_CHUNKS_COUNT; i++) {
+        if (offsets[i]) {
+            used.emplace_back(offsets[i], offsets[i] + sizes[i]);
+        }
+    }
+    std::sort(used.begin(), used.end());
+    std::vector<std::pair<uint32_t, uint32_t>> gaps;
+    size_t end = dataStart;
+    for (const auto& span : used) {
+        if (span.first > end) {
+            gaps.emplace_back(end, span.first);
+        }
+        end = std::max<size_t>(end, span.second);
+    }
+
+    // chunks fitting their old place are rewritten in place (unsaved
+    // chunks are read from the regions cache, not from the file), others 
+    // take the first fitting gap or go to the end of file
+    std::vector<uint> changed;
+    for (uint i = 0; i < REGION_CHUNKS_COUNT; i++) {
+        if (!entry->isChunkUnsaved(i) || chunks[i] == nullptr) {
+            continue;
+        }
+        uint32_t size = newSizes[i];
+        if (!offsets[i] || size > sizes[i]) {
+            auto gap = std::find_if(gaps.begin(), gaps.end(), [=](const auto& gap) {
+                return gap.second - gap.first >= size;
+            });
+            if (gap != gaps.end()) {
+                offsets[i] = gap->first;
+                gap->first += size;
+            } else {
+                offsets[i] = end;
+                end += size;
+            }
+        }
+        sizes[i] = size;
+        changed.push_back(i);
+    }
+    if (end > UINT32_MAX) {
+        return false;
+    }
+
+    size_t usedSpace = 0;
+    for (uint i = 0; i < REGION_CHUNKS_COUNT; i++) {
+        if (offsets[i]) {
+            usedSpace += sizes[i];
+        }
+    }
+    size_t freeSpace = end - std::min(end, dataStart + usedSpace);
+    if (freeSpace > end * REGION_COMPACTION_THRESHOLD) {
+        return false;
+    }
+
+    {
+        std::fstream stream(filename, std::ios::in | std::ios::out | std::ios::binary);
+        if (!stream) {
+            throw std::runtime_error("could not to open file "+filename.u8string());
+        }
+        for (uint i : changed) {
+            stream.seekp(offsets[i]);
+            stream.write((const char*)chunks[i], sizes[i]);
+        }
+        if (!stream) {
+            throw std::runtime_error("could not to write file "+filename.u8string());
+        }
+    }
+
+    // table is replaced after the data is written, so the stored 
+    // table is complete if the write fails
+    ubyte table[REGION_TABLE_SIZE];
+    dataio::write_int32_big(file.generation, table, 0);
+    for (uint i = 0; i < REGION_CHUNKS_COUNT; i++) {
+        size_t pos = 4 + i * REGION_TABLE_ENTRY_SIZE;
+        dataio::write_int32_big(offsets[i], table, pos);
+        dataio::write_int32_big(sizes[i], table, pos + 4);
+    }
+    fs::path tableFile = regfile::getTableFilename(filename);
+    fs::path tmpfile = tableFile;
+    tmpfile += ".tmp";
+    {
+        std::ofstream stream(tmpfile, std::ios::out | std::ios::binary);
+        stream.write((const char*)table, sizeof(table));
+        if (!stream) {
+            throw std::runtime_error("could not to write file "+tmpfile.u8string());
+        }
+    }
+    fs::rename(tmpfile, tableFile);
+    return true;
+}
+
 /// @brief Write or rewrite region file
 /// @param x region X
 /// @param z region Z
@@ -434,45 +1020,68 @@ void WorldFiles::fetchChunks(WorldRegion* region, int x, int z, fs::path folder,
 /// (see REGION_LAYER_* constants)
 void WorldFiles::writeRegion(int x, int z, WorldRegion* entry, fs::path folder, int layer){
     fs::path filename = folder/getRegionFilename(x, z);
+    fs::path tableFile = regfile::getTableFilename(filename);
 
     glm::ivec3 regcoord(x, z, layer);
-    if (getRegFile(regcoord, folder)) {
-        fetchChunks(entry, x, z, folder, layer);
-        openRegFiles.erase(regcoord);
+    uint32_t generation = 0;
+    if (auto rfile = getRegFile(regcoord, folder)) {
+        bool current = uint(rfile->version) == REGION_FORMAT_VERSION;
+        bool updated = current && updateRegion(*rfile, entry, filename);
+        if (!updated) {
+            fetchChunks(entry, x, z, folder, layer);
+        }
+        // table changed, so the file will be reopened on next read
+        closeRegFile(regcoord);
+        if (updated) {
+            entry->setUnsaved(false);
+            return;
+        }
+        if (current) {
+            generation = rfile->generation + 1;
+        }
+    }
+    if (generation == 0) {
+        // table file is not left from a removed or older region file
+        fs::remove(tableFile);
     }
     
+    // written to a temporary file first: the old one may be still
+    // memory-mapped by loader threads
+    fs::path tmpfile = filename;
+    tmpfile += ".tmp";
+
     char header[REGION_HEADER_SIZE] = REGION_FORMAT_MAGIC;
     header[8] = REGION_FORMAT_VERSION;
     header[9] = 0; // flags
-    std::ofstream file(filename, std::ios::out | std::ios::binary);
+    std::ofstream file(tmpfile, std::ios::out | std::ios::binary);
     file.write(header, REGION_HEADER_SIZE);
 
-    size_t offset = REGION_HEADER_SIZE;
-    char intbuf[4]{};
-    uint offsets[REGION_CHUNKS_COUNT]{};
-    
     ubyte** region = entry->getChunks();
     uint32_t* sizes = entry->getSizes();
-    
-    for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
-        ubyte* chunk = region[i];
-        if (chunk == nullptr){
-            offsets[i] = 0;
-        } else {
-            offsets[i] = offset;
 
-            size_t compressedSize = sizes[i];
-            dataio::write_int32_big(compressedSize, (ubyte*)intbuf, 0);
-            offset += 4 + compressedSize;
-
-            file.write(intbuf, 4);
-            file.write((const char*)chunk, compressedSize);
+    size_t offset = REGION_HEADER_SIZE + REGION_TABLE_SIZE;
+    ubyte table[REGION_TABLE_SIZE]{};
+    dataio::write_int32_big(generation, table, 0);
+    for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
+        if (region[i] == nullptr) {
+            continue;
         }
+        size_t pos = 4 + i * REGION_TABLE_ENTRY_SIZE;
+        dataio::write_int32_big(offset, table, pos);
+        dataio::write_int32_big(sizes[i], table, pos + 4);
+        offset += sizes[i];
     }
+    file.write((const char*)table, sizeof(table));
     for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
-        dataio::write_int32_big(offsets[i], (ubyte*)intbuf, 0);
-        file.write(intbuf, 4);
+        if (region[i]) {
+            file.write((const char*)region[i], sizes[i]);
+        }
     }
+    file.close();
+    fs::rename(tmpfile, filename);
+    // table file of the previous generation is not used anymore
+    fs::remove(tableFile);
+    entry->setUnsaved(false);
 }
 
 void WorldFiles::writeRegions(regionsmap& regions, const fs::path& folder, int layer) {
@@ -503,6 +1112,8 @@ void WorldFiles::write(const World* world, const Content* content) {
     }
     
     writeIndices(content->getIndices());
+
+    std::lock_guard<std::mutex> lock(regionsMutex);
     writeRegions(regions, regionsFolder, REGION_LAYER_VOXELS);
     writeRegions(lights, lightsFolder, REGION_LAYER_LIGHTS);
     writeRegions(storages, inventoriesFolder, REGION_LAYER_INVENTORIES);
@@ -544,7 +1155,9 @@ void WorldFiles::writeIndices(const ContentIndices* indices) {
 }
 
 void WorldFiles::writeWorldInfo(const World* world) {
-    files::write_json(getWorldFile(), world->serialize().get());
+    auto root = world->serialize();
+    root->put("region-format", REGION_FORMAT_VERSION);
+    files::write_json(getWorldFile(), root.get());
 }
 
 bool WorldFiles::readWorldInfo(World* world) {
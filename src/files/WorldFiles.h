@@ -2,9 +2,14 @@
 #define FILES_WORLDFILES_H_
 
 #include <map>
+#include <list>
+#include <mutex>
 #include <string>
+#include <vector>
 #include <memory>
+#include <functional>
 #include <unordered_map>
+#include <unordered_set>
 #include <filesystem>
 
 #include <glm/glm.hpp>
@@ -16,8 +21,11 @@
 #include "../settings.h"
 
 #include "../voxels/Chunk.h"
+#include "../util/ThreadPool.h"
 
 inline constexpr uint REGION_HEADER_SIZE = 10;
+/// @brief Size of chunk entry in the v3+ region table: offset and size
+inline constexpr uint REGION_TABLE_ENTRY_SIZE = 8;
 
 inline constexpr uint REGION_LAYER_VOXELS = 0;
 inline constexpr uint REGION_LAYER_LIGHTS = 1;
@@ -26,9 +34,20 @@ inline constexpr uint REGION_LAYER_INVENTORIES = 2;
 inline constexpr uint REGION_SIZE_BIT = 5;
 inline constexpr uint REGION_SIZE = (1 << (REGION_SIZE_BIT));
 inline constexpr uint REGION_CHUNKS_COUNT = ((REGION_SIZE) * (REGION_SIZE));
-inline constexpr uint REGION_FORMAT_VERSION = 2;
+/// @brief Size of the v3+ region table: file generation and chunk entries
+inline constexpr uint REGION_TABLE_SIZE = 
+    4 + REGION_CHUNKS_COUNT * REGION_TABLE_ENTRY_SIZE;
+inline constexpr uint REGION_FORMAT_VERSION = 3;
+/// @brief Voxels data in older region files has no format byte 
+/// (see Chunk::encode)
+inline constexpr uint REGION_ENCODED_VOXELS_VERSION = 3;
+/// @brief Region file is rewritten compactly when free space 
+/// takes more than this part of the file
+inline constexpr float REGION_COMPACTION_THRESHOLD = 0.25f;
 inline constexpr uint WORLD_FORMAT_VERSION = 1;
-inline constexpr uint MAX_OPEN_REGION_FILES = 16;
+inline constexpr uint MAX_CHUNK_LOADER_THREADS = 4;
+/// @brief Part of the regions cache limit left after trimming
+inline constexpr float REGIONS_CACHE_TRIM_TARGET = 0.75f;
 
 class Player;
 class Content;
@@ -46,33 +65,140 @@ public:
 class WorldRegion {
     ubyte** chunksData;
     uint32_t* sizes;
+    /// @brief Chunks changed since the region was written
+    bool* unsavedChunks;
     bool unsaved = false;
+    /// @brief Total size of chunks data in bytes
+    size_t dataSize = 0;
 public:
+    /// @brief Value of the regions access counter on the last access
+    uint64_t lastAccess = 0;
+
     WorldRegion();
     ~WorldRegion();
 
-    void put(uint x, uint z, ubyte* data, uint32_t size);
+    /// @param unsaved false if data is the same as stored in the region file
+    void put(uint x, uint z, ubyte* data, uint32_t size, bool unsaved);
     ubyte* getChunkData(uint x, uint z);
     uint getChunkDataSize(uint x, uint z);
 
+    /// @brief Set region unsaved state. Chunks are marked unsaved 
+    /// by put only, marking region saved clears all chunks state
     void setUnsaved(bool unsaved);
     bool isUnsaved() const;
+    bool isChunkUnsaved(uint index) const;
 
     ubyte** getChunks() const;
     uint32_t* getSizes() const;
+    size_t getDataSize() const;
 };
 
 struct regfile {
-    files::rafile file;
+    fs::path filename;
+    /// @brief File stream (used if file is not memory-mapped)
+    std::unique_ptr<files::rafile> file;
+    std::unique_ptr<files::mmfile> mapping;
     int version;
-
-    regfile(fs::path filename);
+    /// @brief Incremented on every complete rewrite of the file (v3+),
+    /// the updated table file of other generation is outdated
+    uint32_t generation = 0;
+    /// @brief Chunks data offsets table (0 - chunk is not present) 
+    /// read once on file open
+    std::unique_ptr<uint32_t[]> offsets;
+    /// @brief Chunks data sizes table
+    std::unique_ptr<uint32_t[]> sizes;
+
+    /// @param mapped use memory-mapped file instead of stream
+    regfile(fs::path filename, bool mapped);
+
+    /// @brief Read chunks offsets and sizes table. The updated table
+    /// file is used instead of the table in the region file if present
+    void readTable();
+
+    /// @return file of the chunks table updated after the region file 
+    /// was written (see WorldFiles::updateRegion)
+    static fs::path getTableFilename(const fs::path& filename);
+
+    size_t length() const;
+
+    /// @brief Read bytes from file
+    /// @param offset position in the file
+    /// @throws illegal_region_format if out of file bounds 
+    /// (memory-mapped file only)
+    void read(size_t offset, ubyte* dst, size_t size);
+
+    /// @return memory-mapped file content or nullptr if file is not mapped
+    const ubyte* getMappedData() const;
+
+    /// @brief Find chunk data in the region file
+    /// @param index chunk index in region
+    /// @param offset (out argument) chunk data position in the file
+    /// @param size (out argument) chunk data size
+    /// @return false if chunk is not present
+    /// @throws illegal_region_format if chunk is out of file bounds
+    bool findChunk(uint index, uint32_t& offset, uint32_t& size) const;
+
+    /// @return indices of present chunks sorted by data offset
+    std::vector<uint> getChunksOrder() const;
 };
 
 typedef std::unordered_map<glm::ivec2, std::unique_ptr<WorldRegion>> regionsmap;
 
+/// @brief Chunk data read from the world files (all layers)
+struct loaded_chunk {
+    int x = 0;
+    int z = 0;
+    /// @brief Decompressed voxels data (see Chunk::encode) or nullptr
+    std::unique_ptr<ubyte[]> voxels;
+    /// @brief Length of the voxels data
+    size_t voxelsSize = 0;
+    /// @brief Decoded lights cache or nullptr
+    std::unique_ptr<light_t[]> lights;
+    /// @brief Lights cache has all channels (sky light only otherwise)
+    bool fullLights = false;
+    chunk_inventories_map inventories;
+    /// @brief Result of a prefetch job (has no data)
+    bool prefetched = false;
+};
+
+/// @brief Job of the chunks loader threads
+struct chunk_load_job {
+    glm::ivec2 pos {};
+    /// @brief Only read chunk data into the regions cache
+    bool prefetch = false;
+};
+
+using chunks_loader = util::ThreadPool<chunk_load_job, loaded_chunk>;
+
+struct open_regfile {
+    std::shared_ptr<regfile> file;
+    /// @brief Position in the recently used files list
+    std::list<glm::ivec3>::iterator usage;
+};
+
 class WorldFiles {
-    std::unordered_map<glm::ivec3, std::unique_ptr<regfile>> openRegFiles;
+    /// @brief Region files are shared with loader threads reading 
+    /// memory-mapped data outside of the lock
+    std::unordered_map<glm::ivec3, open_regfile> openRegFiles;
+    /// @brief Open region files coords, the most recently used first
+    std::list<glm::ivec3> regFilesUsage;
+    uint regFilesLimit;
+    size_t regFilesHits = 0;
+    size_t regFilesMisses = 0;
+    /// @brief Incremented on every region access
+    uint64_t regionsAccessCounter = 0;
+    /// @brief Regions accessed after the last trim are not evicted
+    uint64_t lastTrimAccess = 0;
+    size_t regionsCacheLimit;
+    /// @brief Guards regions maps and open region files
+    /// (chunks are read by the loader threads)
+    std::mutex regionsMutex;
+    /// @brief Requested chunks not taken with pollChunk yet (main thread)
+    std::unordered_set<glm::ivec2> requestedChunks;
+    /// @brief Chunks with full lights cache invalidated, the cache may be
+    /// being read at the moment (main thread)
+    std::unordered_set<glm::ivec2> staleLights;
+    std::unique_ptr<chunks_loader> loader;
 
     void writeWorldInfo(const World* world);
     fs::path getRegionFilename(int x, int y) const;
@@ -99,19 +225,50 @@ class WorldFiles {
 
     ubyte* readChunkData(int x, int y, uint32_t& length, fs::path folder, int layer);
 
+    /// @brief Read chunk data from the region file. Voxels data of older 
+    /// format is converted to the current one
+    /// @param index chunk index in region
+    /// @param size (out argument) data length
+    /// @return chunk data or nullptr if chunk is not present
+    ubyte* readChunk(regfile& file, uint index, int layer, uint32_t& size);
+
+    /// @brief Convert compressed voxels data of the region format 
+    /// older than REGION_ENCODED_VOXELS_VERSION (thread-safe)
+    static ubyte* upgradeVoxels(const ubyte* src, size_t srclen, uint32_t& size);
+
     void fetchChunks(WorldRegion* region, int x, int y, fs::path folder, int layer);
 
     void writeRegions(regionsmap& regions, const fs::path& folder, int layer);
 
-    ubyte* getData(regionsmap& regions, const fs::path& folder, int x, int z, int layer, bool compression);
+    /// @brief Write unsaved chunks to the existing region file: in place
+    /// if fits, to free space or to the end of file. The updated chunks 
+    /// table is written to the separate table file
+    /// @return false if region file needs to be compacted (rewritten)
+    bool updateRegion(regfile& file, WorldRegion* entry, const fs::path& filename);
+
+    /// @brief Get stored chunk data (not thread-safe).
+    /// Returned data stays valid after the regions mutex is released:
+    /// it's a copy or a pointer to the memory-mapped region file 
+    /// kept alive by the returned pointer
+    /// @param size (out argument) length of the data
+    /// @return chunk data or nullptr if chunk data not found
+    std::shared_ptr<const ubyte> getData(regionsmap& regions, const fs::path& folder, int x, int z, int layer, uint32_t& size);
     
-    regfile* getRegFile(glm::ivec3 coord, const fs::path& folder);
+    std::shared_ptr<regfile> getRegFile(glm::ivec3 coord, const fs::path& folder);
+    void closeRegFile(glm::ivec3 coord);
 
-    fs::path getLightsFolder() const;
-    fs::path getInventoriesFolder() const;
+    /// @brief Read chunk data into the regions cache if not cached yet
+    void prefetchData(regionsmap& regions, const fs::path& folder, int x, int z, int layer);
+
+    /// @brief Read all chunk layers into the regions cache (thread-safe)
+    void prefetchChunk(int x, int z);
+
+    chunks_loader& getLoader();
 public:
     static bool parseRegionFilename(const std::string& name, int& x, int& y);
     fs::path getRegionsFolder() const;
+    fs::path getLightsFolder() const;
+    fs::path getInventoriesFolder() const;
     fs::path getPlayerFile() const;
 
     regionsmap regions;
@@ -121,6 +278,11 @@ public:
     std::unique_ptr<ubyte[]> compressionBuffer;
     bool generatorTestMode;
     bool doWriteLights;
+    /// @brief Write lights cache of all channels (see Lightmap::encodeFull)
+    bool doWriteFullLights;
+    /// @brief Use memory-mapped region files
+    bool mmapRegions;
+    bool regionsReadAhead;
 
     WorldFiles(fs::path directory, const DebugSettings& settings);
     ~WorldFiles();
@@ -128,17 +290,97 @@ public:
     void createDirectories();
 
     void put(Chunk* chunk);
-    void put(int x, int z, const ubyte* voxelData);
+    /// @param voxelData encoded voxels (see Chunk::encode)
+    /// @param size encoded voxels data length
+    void put(int x, int z, const ubyte* voxelData, size_t size);
 
     int getVoxelRegionVersion(int x, int z);
+
+    /// @brief Get format version of the world region files stored 
+    /// in world.json (REGION_FORMAT_VERSION if world is not written yet)
     int getVoxelRegionsVersion();
 
-    ubyte* getChunk(int x, int z);
-    light_t* getLights(int x, int z);
+    /// @brief Store current region format version in world.json
+    /// (all regions have been upgraded)
+    void writeRegionsVersion();
+
+    /// @brief Mark region unsaved to be rewritten in the current format 
+    /// on the next write
+    /// @param layer see REGION_LAYER_* constants
+    void upgradeRegion(int x, int z, int layer);
+
+    /// @brief Get encoded chunk voxels (see Chunk::decode)
+    /// @param size (out argument) data length
+    /// @return encoded voxels or nullptr if chunk is not stored
+    ubyte* getChunk(int x, int z, size_t& size);
+    /// @brief Get cached lights (sky light only or all channels)
+    /// @param full (out argument) lights have all channels
+    /// @return lights or nullptr if not stored or format is not supported
+    light_t* getLights(int x, int z, bool& full);
     chunk_inventories_map fetchInventories(int x, int z);
 
+    /// @brief Replace full lights cache of the chunk with sky light only,
+    /// so its block light is computed again on load (main thread)
+    void invalidateFullLights(int x, int z);
+
+    /// @brief Read all chunk layers (thread-safe)
+    loaded_chunk loadChunk(int x, int z);
+
+    /// @brief Enqueue chunk to be read by the loader threads.
+    /// Does nothing if chunk is already requested
+    void requestChunk(int x, int z);
+
+    /// @brief Cancel chunk request. Chunk will not be returned by
+    /// pollChunk even if it's being read at the moment
+    void cancelChunk(int x, int z);
+
+    /// @brief Cancel all chunk requests outside of the area
+    /// @param x area min chunk X
+    /// @param z area min chunk Z
+    /// @param w area width (chunks)
+    /// @param d area depth (chunks)
+    void cancelChunksOutside(int x, int z, int w, int d);
+
+    bool isChunkRequested(int x, int z) const;
+    size_t countRequestedChunks() const;
+
+    /// @brief Enqueue low priority jobs reading stored chunks data of 
+    /// the area into the regions cache to make following chunks loading
+    /// cheaper. Jobs are not cancelled by cancelChunksOutside.
+    /// Does nothing if read-ahead is disabled or region files 
+    /// are memory-mapped
+    /// @param x area min chunk X
+    /// @param z area min chunk Z
+    /// @param w area width (chunks)
+    /// @param d area depth (chunks)
+    void prefetchChunks(int x, int z, int w, int d);
+
+    /// @brief Remove prefetch jobs not started yet
+    void cancelPrefetch();
+
+    /// @brief Remove saved regions from the cache, least recently used 
+    /// first, if the cache exceeds its memory limit (thread-safe).
+    /// Unsaved regions stay until the world is written.
+    /// Regions accessed since the previous call are kept
+    void trimRegionsCache();
+
+    /// @param layer see REGION_LAYER_* constants
+    /// @return bytes of chunks data held in the layer regions cache
+    size_t getRegionsCacheSize(int layer);
+
+    size_t getRegFilesHits();
+    size_t getRegFilesMisses();
+    size_t countOpenRegFiles();
+
+    /// @brief Take one requested chunk that has been read
+    /// @param dst destination
+    /// @return false if no requested chunks ready
+    bool pollChunk(loaded_chunk& dst);
+
     bool readWorldInfo(World* world);
 
+    /// @brief Write unsaved region chunks. Region file of older format
+    /// or too fragmented is rewritten completely
     void writeRegion(int x, int y, WorldRegion* entry, fs::path file, int layer);
 
     /// @brief Write all unsaved data to world files
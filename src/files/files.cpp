@@ -10,6 +10,14 @@
 #include "../util/stringutil.h"
 #include "../data/dynamic.h"
 
+#if defined(__unix__) || defined(__APPLE__)
+#define FILES_MMAP_SUPPORTED
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 namespace fs = std::filesystem;
 
 files::rafile::rafile(fs::path filename)
@@ -33,6 +41,64 @@ void files::rafile::read(char* buffer, std::streamsize size) {
     file.read(buffer, size);
 }
 
+#ifdef FILES_MMAP_SUPPORTED
+
+files::mmfile::mmfile(fs::path filename) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1) {
+        throw std::runtime_error("could not to open file "+filename.string());
+    }
+    struct stat info;
+    if (fstat(fd, &info) == -1) {
+        close(fd);
+        throw std::runtime_error("could not to stat file "+filename.string());
+    }
+    filelength = info.st_size;
+    if (filelength) {
+        void* ptr = mmap(nullptr, filelength, PROT_READ, MAP_SHARED, fd, 0);
+        if (ptr == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("could not to map file "+filename.string());
+        }
+        data = static_cast<const ubyte*>(ptr);
+    }
+    // mapping stays valid after the descriptor is closed
+    close(fd);
+}
+
+files::mmfile::~mmfile() {
+    if (data) {
+        munmap(const_cast<ubyte*>(data), filelength);
+    }
+}
+
+bool files::mmfile::supported() {
+    return true;
+}
+
+#else
+
+files::mmfile::mmfile(fs::path filename) {
+    throw std::runtime_error("memory-mapped files are not supported");
+}
+
+files::mmfile::~mmfile() {
+}
+
+bool files::mmfile::supported() {
+    return false;
+}
+
+#endif // FILES_MMAP_SUPPORTED
+
+const ubyte* files::mmfile::getData() const {
+    return data;
+}
+
+size_t files::mmfile::length() const {
+    return filelength;
+}
+
 bool files::write_bytes(fs::path filename, const ubyte* data, size_t size) {
 	std::ofstream output(filename, std::ios::binary);
 	if (!output.is_open())
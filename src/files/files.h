@@ -27,6 +27,27 @@ namespace files {
         size_t length() const;
     };
 
+    /// @brief Read-only memory-mapped file.
+    /// Available on POSIX platforms only (see mmfile::supported)
+    class mmfile {
+        const ubyte* data = nullptr;
+        size_t filelength = 0;
+    public:
+        mmfile(std::filesystem::path filename);
+        ~mmfile();
+
+        mmfile(const mmfile&) = delete;
+        mmfile& operator=(const mmfile&) = delete;
+
+        /// @return pointer to the mapped file content 
+        /// (nullptr if file is empty)
+        const ubyte* getData() const;
+        size_t length() const;
+
+        /// @brief Check if memory-mapped files are supported by platform
+        static bool supported();
+    };
+
     /// @brief Write bytes array to the file without any extra data
     /// @param file target file
     /// @param data data bytes array
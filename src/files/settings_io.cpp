@@ -51,6 +51,11 @@ toml::Wrapper* create_wrapper(EngineSettings& settings) {
     debug.add("generator-test-mode", &settings.debug.generatorTestMode);
     debug.add("show-chunk-borders", &settings.debug.showChunkBorders);
     debug.add("do-write-lights", &settings.debug.doWriteLights);
+    debug.add("do-write-full-lights", &settings.debug.doWriteFullLights);
+    debug.add("mmap-regions", &settings.debug.mmapRegions);
+    debug.add("region-files-limit", &settings.debug.regionFilesLimit);
+    debug.add("regions-read-ahead", &settings.debug.regionsReadAhead);
+    debug.add("regions-cache-limit", &settings.debug.regionsCacheLimit);
 
     toml::Section& ui = wrapper->add("ui");
     ui.add("language", &settings.ui.language);
@@ -9,8 +9,13 @@
 #include "../physics/Hitbox.h"
 #include "../world/Level.h"
 #include "../world/World.h"
+#include "../files/WorldFiles.h"
 #include "../voxels/Chunks.h"
+#include "../voxels/ChunksStorage.h"
+#include "../voxels/ChunkPool.h"
 #include "../voxels/Block.h"
+#include "../lighting/Lighting.h"
+#include "../logic/ChunksController.h"
 #include "../util/stringutil.h"
 #include "../delegates.h"
 #include "../engine.h"
@@ -50,6 +55,28 @@ std::shared_ptr<UINode> create_debug_panel(
         fpsMax = fps;
     });
     panel->add(create_label([](){ return L"fps: "+fpsString;}));
+
+    static size_t prevChunksLighted = Lighting::chunksLighted;
+    static std::wstring chunksLightedString = L"";
+    panel->listenInterval(1.0f, []() {
+        size_t lighted = Lighting::chunksLighted;
+        chunksLightedString = std::to_wstring(lighted - prevChunksLighted);
+        prevChunksLighted = lighted;
+    });
+    panel->add(create_label([](){ 
+        return L"chunks lit/s: "+chunksLightedString;
+    }));
+
+    static size_t prevChunksGenerated = ChunksController::chunksGenerated;
+    static std::wstring chunksGeneratedString = L"";
+    panel->listenInterval(1.0f, []() {
+        size_t generated = ChunksController::chunksGenerated;
+        chunksGeneratedString = std::to_wstring(generated - prevChunksGenerated);
+        prevChunksGenerated = generated;
+    });
+    panel->add(create_label([](){ 
+        return L"chunks generated/s: "+chunksGeneratedString;
+    }));
    
     panel->add(create_label([](){
         return L"meshes: " + std::to_wstring(Mesh::meshesCount);
@@ -67,6 +94,27 @@ std::shared_ptr<UINode> create_debug_panel(
         return L"chunks: "+std::to_wstring(level->chunks->chunksCount)+
                L" visible: "+std::to_wstring(level->chunks->visible);
     }));
+    panel->add(create_label([=]() {
+        auto* pool = level->chunksStorage->getPool();
+        return L"chunks pool: "+std::to_wstring(pool->size())+
+               L" hits: "+std::to_wstring(pool->getHits())+
+               L" misses: "+std::to_wstring(pool->getMisses());
+    }));
+    panel->add(create_label([=]() {
+        auto* wfile = level->world->wfile.get();
+        return L"region files: "+std::to_wstring(wfile->countOpenRegFiles())+
+               L" hits: "+std::to_wstring(wfile->getRegFilesHits())+
+               L" misses: "+std::to_wstring(wfile->getRegFilesMisses());
+    }));
+    panel->add(create_label([=]() {
+        auto* wfile = level->world->wfile.get();
+        auto kib = [=](int layer) {
+            return std::to_wstring(wfile->getRegionsCacheSize(layer) / 1024);
+        };
+        return L"regions cache KiB: "+kib(REGION_LAYER_VOXELS)+
+               L" / "+kib(REGION_LAYER_LIGHTS)+
+               L" / "+kib(REGION_LAYER_INVENTORIES);
+    }));
     panel->add(create_label([=](){
         auto* indices = level->content->getIndices();
         auto def = indices->getBlockDef(player->selectedVoxel.id);
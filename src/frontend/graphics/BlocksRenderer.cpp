@@ -35,6 +35,7 @@ BlocksRenderer::BlocksRenderer(size_t capacity,
 	indexBuffer = new int[capacity];
 	voxelsBuffer = new VoxelsVolume(CHUNK_W + 2, CHUNK_H, CHUNK_D + 2);
 	blockDefsCache = content->getIndices()->getBlockDefs();
+	blockProps = &content->getIndices()->getBlockProps();
 }
 
 BlocksRenderer::~BlocksRenderer() {
@@ -344,8 +345,8 @@ bool BlocksRenderer::isOpen(int x, int y, int z, ubyte group) const {
 											 chunk->z * CHUNK_D + z);
 	if (id == BLOCK_VOID)
 		return false;
-	const Block& block = *blockDefsCache[id];
-	if ((block.drawGroup != group && block.lightPassing) || !block.rt.solid) {
+	const auto& props = *blockProps;
+	if ((props.drawGroup[id] != group && props.lightPassing[id]) || !props.solid[id]) {
 		return true;
 	}
 	return !id;
@@ -357,8 +358,7 @@ bool BlocksRenderer::isOpenForLight(int x, int y, int z) const {
 											 chunk->z * CHUNK_D + z);
 	if (id == BLOCK_VOID)
 		return false;
-	const Block& block = *blockDefsCache[id];
-	if (block.lightPassing) {
+	if (blockProps->lightPassing[id]) {
 		return true;
 	}
 	return !id;
@@ -399,16 +399,24 @@ vec4 BlocksRenderer::pickSoftLight(float x, float y, float z,
 	return pickSoftLight({int(round(x)), int(round(y)), int(round(z))}, right, up);
 }
 
-void BlocksRenderer::render(const voxel* voxels) {
+void BlocksRenderer::render() {
+	const auto& voxels = chunk->voxels;
+	const ubyte* drawGroups = blockProps->drawGroup.data();
 	int begin = chunk->bottom * (CHUNK_W * CHUNK_D);
 	int end = chunk->top * (CHUNK_W * CHUNK_D);
 	for (const auto drawGroup : *content->drawGroups) {
 		for (int i = begin; i < end; i++) {
+			uint section = i / CHUNK_SECTION_VOL;
+			// sections of air only have nothing to render
+			if (voxels.isUniform(section) && voxels.getUniform(section).id == 0) {
+				i = (section + 1) * CHUNK_SECTION_VOL - 1;
+				continue;
+			}
 			const voxel& vox = voxels[i];
 			blockid_t id = vox.id;
-			const Block& def = *blockDefsCache[id];
-			if (id == 0 || def.drawGroup != drawGroup)
+			if (id == 0 || drawGroups[id] != drawGroup)
 				continue;
+			const Block& def = *blockDefsCache[id];
 			const UVRegion texfaces[6]{ cache->getRegion(id, 0), 
 										cache->getRegion(id, 1),
 										cache->getRegion(id, 2), 
@@ -451,8 +459,7 @@ void BlocksRenderer::build(const Chunk* chunk, const ChunksStorage* chunks) {
 	overflow = false;
 	vertexOffset = 0;
 	indexOffset = indexSize = 0;
-	const voxel* voxels = chunk->voxels;
-	render(voxels);
+	render();
 }
 
 Mesh* BlocksRenderer::createMesh() {
@@ -12,6 +12,7 @@
 class Content;
 class Mesh;
 class Block;
+struct block_props;
 class Chunk;
 class Chunks;
 class VoxelsVolume;
@@ -34,6 +35,7 @@ class BlocksRenderer {
 	VoxelsVolume* voxelsBuffer;
 
 	const Block* const* blockDefsCache;
+	const block_props* blockProps;
 	const ContentGfxCache* const cache;
 	const EngineSettings& settings;
 
@@ -88,7 +90,7 @@ class BlocksRenderer {
 	glm::vec4 pickLight(const glm::ivec3& coord) const;
 	glm::vec4 pickSoftLight(const glm::ivec3& coord, const glm::ivec3& right, const glm::ivec3& up) const;
 	glm::vec4 pickSoftLight(float x, float y, float z, const glm::ivec3& right, const glm::ivec3& up) const;
-	void render(const voxel* voxels);
+	void render();
 public:
 	BlocksRenderer(size_t capacity, const Content* content, const ContentGfxCache* cache, const EngineSettings& settings);
 	virtual ~BlocksRenderer();
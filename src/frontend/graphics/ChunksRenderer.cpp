@@ -120,7 +120,8 @@ void ChunksRenderer::unload(Chunk* chunk) {
 std::shared_ptr<Mesh> ChunksRenderer::getOrRender(std::shared_ptr<Chunk> chunk, bool important) {
 	auto found = meshes.find(glm::ivec2(chunk->x, chunk->z));
 	if (found != meshes.end()){
-        if (chunk->isModified()) {
+        // mesh is kept until lights update is finished
+        if (chunk->isModified() && !chunk->isLightDirty()) {
             render(chunk, important);
         }
 		return found->second;
@@ -134,6 +134,13 @@ void show_process_panel(Engine* engine, std::shared_ptr<WorldConverter> converte
     menu->setPage("process", false);
 }
 
+/// @brief Check if world regions are stored in an outdated format
+/// (region format version is stored in world.json)
+static bool is_upgrade_required(const fs::path& folder, const EngineSettings& settings) {
+    WorldFiles wfile(folder, settings.debug);
+    return wfile.getVoxelRegionsVersion() < int(REGION_FORMAT_VERSION);
+}
+
 void show_convert_request(
     Engine* engine, 
     const Content* content, 
@@ -198,8 +205,8 @@ void menus::open_world(std::string name, Engine* engine, bool confirmConvert) {
     auto& settings = engine->getSettings();
 
     std::shared_ptr<ContentLUT> lut (World::checkIndices(folder, content));
-    if (lut) {
-        if (lut->hasMissingContent()) {
+    if (lut || is_upgrade_required(folder, settings)) {
+        if (lut && lut->hasMissingContent()) {
             show_content_missing(engine, content, lut);
         } else {
             if (confirmConvert) {
@@ -217,7 +224,10 @@ void menus::open_world(std::string name, Engine* engine, bool confirmConvert) {
             Level* level = World::load(folder, settings, content, packs);
             level->world->wfile->createDirectories();
             engine->setScreen(std::make_shared<LevelScreen>(engine, level));
-        } catch (const world_load_error& error) {
+        } catch (const std::runtime_error& error) {
+            // world_load_error or the world generator could not be
+            // created (e.g. a block it uses is missing)
+            engine->getPaths()->setWorldFolder(fs::path());
             guiutil::alert(
                 engine->getGUI(), langs::get(L"Error")+L": "+
                 util::str2wstr_utf8(error.what())
@@ -254,8 +264,8 @@ void menus::open_dimension(std::string name, Engine* engine, bool confirmConvert
     auto& settings = engine->getSettings();
 
     std::shared_ptr<ContentLUT> lut(World::checkIndices(folder, content));
-    if (lut) {
-        if (lut->hasMissingContent()) {
+    if (lut || is_upgrade_required(folder, settings)) {
+        if (lut && lut->hasMissingContent()) {
             show_content_missing(engine, content, lut);
         }
         else {
@@ -277,7 +287,8 @@ void menus::open_dimension(std::string name, Engine* engine, bool confirmConvert
             level->world->wfile->createDirectories();
             engine->setScreen(std::make_shared<LevelScreen>(engine, level));
         }
-        catch (const world_load_error& error) {
+        catch (const std::runtime_error& error) {
+            engine->getPaths()->setWorldFolder(fs::path());
             guiutil::alert(
                 engine->getGUI(), langs::get(L"Error") + L": " +
                 util::str2wstr_utf8(error.what())
@@ -152,9 +152,26 @@ void menus::create_new_world_panel(Engine* engine) {
             engine->getContent(),
             engine->getContentPacks()
         );
+        bool folderExisted = fs::exists(folder);
         level->world->wfile->createDirectories();
+        std::shared_ptr<LevelScreen> screen;
+        try {
+            // level is owned by the screen (deleted if construction fails)
+            screen = std::make_shared<LevelScreen>(engine, level);
+        } catch (const std::runtime_error& error) {
+            // e.g. a block used by the world generator is missing
+            paths->setWorldFolder(fs::path());
+            if (!folderExisted) {
+                fs::remove_all(folder);
+            }
+            guiutil::alert(
+                engine->getGUI(),
+                langs::get(L"Error")+L": "+util::str2wstr_utf8(error.what())
+            );
+            return;
+        }
         menus::generatorID = WorldGenerators::getDefaultGeneratorID();
-        engine->setScreen(std::make_shared<LevelScreen>(engine, level));
+        engine->setScreen(screen);
     }));
     panel->add(guiutil::backButton(engine->getGUI()->getMenu()));
 }
@@ -1,5 +1,7 @@
 #include <iostream>
+#include <stdint.h>
 #include <assert.h>
+#include <algorithm>
 #include "LightSolver.h"
 #include "Lightmap.h"
 #include "../content/Content.h"
@@ -8,107 +10,309 @@
 #include "../voxels/voxel.h"
 #include "../voxels/Block.h"
 
-LightSolver::LightSolver(const ContentIndices* contentIds, Chunks* chunks, int channel) 
-	: contentIds(contentIds), 
-	  chunks(chunks), 
-	  channel(channel) {
+// Channels are processed all at once with packed light spread to bytes
+// (0xSBGR -> 0x0S0B0G0R). Values are 4-bit, so byte-wise arithmetic with
+// the high bit of each byte preset never borrows from the next byte
+static constexpr uint32_t BYTES_HIGH_BIT = 0x80808080;
+static constexpr uint32_t BYTES_ONE = 0x01010101;
+
+/// @brief Initial capacity of the solver queues (entries)
+static constexpr size_t LIGHT_QUEUE_CAPACITY = 1 << 14;
+
+static inline uint32_t unpack_light(light_t light) {
+	uint32_t x = light;
+	x = (x | (x << 8)) & 0x00FF00FF;
+	x = (x | (x << 4)) & 0x0F0F0F0F;
+	return x;
 }
 
-void LightSolver::add(int x, int y, int z, int emission) {
-	if (emission <= 1)
-		return;
+static inline light_t pack_light(uint32_t x) {
+	x = (x | (x >> 4)) & 0x00FF00FF;
+	x = (x | (x >> 8)) & 0x0000FFFF;
+	return light_t(x);
+}
+
+/// @return 0xFF in bytes having the high bit set, 0 in others
+static inline uint32_t bytes_mask(uint32_t bits) {
+	return ((bits & BYTES_HIGH_BIT) >> 7) * 0xFF;
+}
+
+/// @return high bit set in bytes where a >= b
+static inline uint32_t bytes_ge(uint32_t a, uint32_t b) {
+	return ((a | BYTES_HIGH_BIT) - b) & BYTES_HIGH_BIT;
+}
+
+/// @return byte-wise minimum of a and b
+static inline uint32_t bytes_min(uint32_t a, uint32_t b) {
+	uint32_t greater = bytes_mask(bytes_ge(a, b));
+	return (b & greater) | (a & ~greater);
+}
 
-	addqueue.push(lightentry {x, y, z, ubyte(emission)});
+/// @return high bit set in not zero bytes
+static inline uint32_t bytes_nonzero(uint32_t a) {
+	return bytes_ge(a, BYTES_ONE);
+}
 
+LightSolver::LightSolver(const ContentIndices* contentIds, Chunks* chunks)
+	: addqueue(LIGHT_QUEUE_CAPACITY),
+	  remqueue(LIGHT_QUEUE_CAPACITY),
+	  contentIds(contentIds),
+	  chunks(chunks) {
+}
+
+Chunk* LightSolver::locate(int x, int y, int z, lightentry& entry) {
 	Chunk* chunk = chunks->getChunkByVoxel(x, y, z);
-	chunk->setModified(true);
-	chunk->lightmap.set(x-chunk->x*CHUNK_W, y, z-chunk->z*CHUNK_D, channel, emission);
+	if (chunk) {
+		entry.slot = chunks->indexOf(chunk->x, chunk->z);
+		entry.index = vox_index(x-chunk->x*CHUNK_W, y, z-chunk->z*CHUNK_D);
+	}
+	return chunk;
 }
 
-void LightSolver::add(int x, int y, int z) {
+template<class F, class U>
+inline void LightSolver::forEachNeighbour(
+	const lightentry& entry, const F& func, const U& unreached
+) {
+	constexpr uint STEP_Z = CHUNK_W;
+	constexpr uint STEP_Y = CHUNK_W * CHUNK_D;
+
+	Chunk* chunk = chunks->chunks[entry.slot].get();
+	if (chunk == nullptr) {
+		return;
+	}
+	uint index = entry.index;
+	uint x = index % CHUNK_W;
+	uint z = index / STEP_Z % CHUNK_D;
+	uint y = index / STEP_Y;
+
+	// the same voxel of the adjacent chunk
+	auto adjacent = [this, chunk, &func, &unreached](int dx, int dz, uint index) {
+		int cx = chunk->x + dx;
+		int cz = chunk->z + dz;
+		if (cx < chunks->ox || cz < chunks->oz ||
+			cx >= chunks->ox + int(chunks->w) || 
+			cz >= chunks->oz + int(chunks->d)) {
+			unreached(cx, cz);
+			return;
+		}
+		uint32_t slot = chunks->indexOf(cx, cz);
+		if (Chunk* other = chunks->chunks[slot].get()) {
+			func(other, slot, index);
+		} else {
+			unreached(cx, cz);
+		}
+	};
+
+	if (z < CHUNK_D-1) {
+		func(chunk, entry.slot, index + STEP_Z);
+	} else {
+		adjacent(0, 1, index - STEP_Z * (CHUNK_D-1));
+	}
+	if (z > 0) {
+		func(chunk, entry.slot, index - STEP_Z);
+	} else {
+		adjacent(0, -1, index + STEP_Z * (CHUNK_D-1));
+	}
+	if (y < CHUNK_H-1) {
+		func(chunk, entry.slot, index + STEP_Y);
+	}
+	if (y > 0) {
+		func(chunk, entry.slot, index - STEP_Y);
+	}
+	if (x < CHUNK_W-1) {
+		func(chunk, entry.slot, index + 1);
+	} else {
+		adjacent(1, 0, index - (CHUNK_W-1));
+	}
+	if (x > 0) {
+		func(chunk, entry.slot, index - 1);
+	} else {
+		adjacent(-1, 0, index + (CHUNK_W-1));
+	}
+}
+
+void LightSolver::set(int x, int y, int z, light_t light) {
+	// channels with light 0 or 1 do not spread
+	light_t mask = 0;
+	for (int channel = 0; channel < 4; channel++) {
+		int shift = channel << 2;
+		if (((light >> shift) & 0xF) > 1) {
+			mask |= 0xF << shift;
+		}
+	}
+	light_t spread = light & mask;
+	if (spread == 0)
+		return;
+
+	lightentry entry;
+	Chunk* chunk = locate(x, y, z, entry);
+	touch(chunk);
+
+	auto& map = chunk->lightmap.map;
+	light_t prev = map[entry.index];
+	light_t next = light_t((prev & ~mask) | spread);
+	if (next != prev) {
+		map.set(entry.index, next);
+		chunk->setUnsavedLights(true);
+	}
+
+	entry.light = spread;
+	addqueue.push(entry);
+}
+
+void LightSolver::add(int x, int y, int z, light_t mask) {
 	assert (chunks != nullptr);
-	add(x,y,z, chunks->getLight(x,y,z, channel));
+	set(x,y,z, chunks->getLight(x,y,z) & mask);
 }
 
-void LightSolver::remove(int x, int y, int z) {
-	Chunk* chunk = chunks->getChunkByVoxel(x, y, z);
+void LightSolver::remove(int x, int y, int z, light_t mask) {
+	lightentry entry;
+	Chunk* chunk = locate(x, y, z, entry);
 	if (chunk == nullptr)
 		return;
 
-	ubyte light = chunk->lightmap.get(x-chunk->x*CHUNK_W, y, z-chunk->z*CHUNK_D, channel);
-	if (light == 0){
+	auto& map = chunk->lightmap.map;
+	light_t light = map[entry.index];
+	if ((light & mask) == 0){
 		return;
 	}
-	remqueue.push(lightentry {x, y, z, light});
-	chunk->lightmap.set(x-chunk->x*CHUNK_W, y, z-chunk->z*CHUNK_D, channel, 0);
+	entry.light = light & mask;
+	remqueue.push(entry);
+	map.set(entry.index, light_t(light & ~mask));
+	chunk->setUnsavedLights(true);
 }
 
-void LightSolver::solve(){
-	const int coords[] = {
-			0, 0, 1,
-			0, 0,-1,
-			0, 1, 0,
-			0,-1, 0,
-			1, 0, 0,
-		   -1, 0, 0
-	};
+inline void LightSolver::touch(Chunk* chunk) {
+	if (!chunk->isLightDirty()) {
+		chunk->setLightDirty(true);
+		dirtyChunks.emplace_back(chunk->x, chunk->z);
+	}
+	chunk->setModified(true);
+}
 
-	while (!remqueue.empty()){
-		const lightentry entry = remqueue.front();
-		remqueue.pop();
-
-		for (int i = 0; i < 6; i++) {
-			int imul3 = i*3;
-			int x = entry.x+coords[imul3];
-			int y = entry.y+coords[imul3+1];
-			int z = entry.z+coords[imul3+2];
-			
-			Chunk* chunk = chunks->getChunkByVoxel(x,y,z);
-			if (chunk) {
-				int lx = x - chunk->x * CHUNK_W;
-				int lz = z - chunk->z * CHUNK_D;
-				chunk->setModified(true);
-
-				ubyte light = chunk->lightmap.get(lx,y,lz, channel);
-				if (light != 0 && light == entry.light-1){
-					remqueue.push(lightentry {x, y, z, light});
-					chunk->lightmap.set(lx, y, lz, channel, 0);
-				}
-				else if (light >= entry.light){
-					addqueue.push(lightentry {x, y, z, light});
-				}
-			}
+void LightSolver::settle() {
+	for (const auto& pos : dirtyChunks) {
+		if (Chunk* chunk = chunks->getChunk(pos.x, pos.y)) {
+			chunk->setLightDirty(false);
 		}
 	}
+	dirtyChunks.clear();
+}
 
-	const Block* const* blockDefs = contentIds->getBlockDefs();
-	while (!addqueue.empty()){
-		const lightentry entry = addqueue.front();
-		addqueue.pop();
-
-		for (int i = 0; i < 6; i++) {
-			int imul3 = i*3;
-			int x = entry.x+coords[imul3];
-			int y = entry.y+coords[imul3+1];
-			int z = entry.z+coords[imul3+2];
-
-			Chunk* chunk = chunks->getChunkByVoxel(x,y,z);
-			if (chunk) {
-				int lx = x - chunk->x * CHUNK_W;
-				int lz = z - chunk->z * CHUNK_D;
-				chunk->setModified(true);
-
-				ubyte light = chunk->lightmap.get(lx, y, lz, channel);
-				voxel& v = chunk->voxels[vox_index(lx, y, lz)];
-				const Block* block = blockDefs[v.id];
-				if (block->lightPassing && light+2 <= entry.light){
-					chunk->lightmap.set(
-						x-chunk->x*CHUNK_W, y, z-chunk->z*CHUNK_D, 
-						channel, 
-						entry.light-1);
-					addqueue.push(lightentry {x, y, z, ubyte(entry.light-1)});
-				}
+size_t LightSolver::solveRemovals(size_t maxEntries){
+	size_t count = 0;
+	for (; count < maxEntries && !remqueue.empty(); count++){
+		const lightentry entry = remqueue.pop();
+		const uint32_t source = unpack_light(entry.light);
+		const uint32_t sourceNonZero = bytes_nonzero(source);
+		// only caches of block light are invalidated
+		const bool blockLight = (entry.light & 0x0FFF) != 0;
+
+		auto unreached = [this, blockLight](int cx, int cz) {
+			glm::ivec2 pos (cx, cz);
+			if (blockLight && std::find(unreachedChunks.begin(), 
+				unreachedChunks.end(), pos) == unreachedChunks.end()) {
+				unreachedChunks.push_back(pos);
+			}
+		};
+		forEachNeighbour(entry, [=](Chunk* chunk, uint32_t slot, uint index) {
+			touch(chunk);
+
+			auto& map = chunk->lightmap.map;
+			uint32_t light = unpack_light(map[index]);
+			// light spread by the entry (source - 1) is removed,
+			// brighter light is spread again to fill the gap
+			uint32_t removed = bytes_mask(
+				bytes_nonzero(light) & 
+				~bytes_nonzero((light + BYTES_ONE) ^ source)
+			);
+			uint32_t respread = bytes_mask(
+				sourceNonZero & bytes_ge(light, source)
+			);
+			if (removed) {
+				remqueue.push(lightentry {
+					slot, index, pack_light(light & removed)
+				});
+				map.set(index, pack_light(light & ~removed));
+				chunk->setUnsavedLights(true);
+			}
+			if (respread) {
+				addqueue.push(lightentry {
+					slot, index, pack_light(light & respread)
+				});
 			}
+		}, unreached);
+	}
+	return count;
+}
+
+size_t LightSolver::solveAdditions(size_t maxEntries){
+	const ubyte* lightPassing = contentIds->getBlockProps().lightPassing.data();
+	size_t count = 0;
+	for (; count < maxEntries && !addqueue.empty(); count++){
+		const lightentry entry = addqueue.pop();
+		const Chunk* chunk = chunks->chunks[entry.slot].get();
+		if (chunk == nullptr) {
+			continue;
 		}
+		// light removed after the entry was queued (by another removal
+		// solved at the same time) is not spread
+		const uint32_t source = bytes_min(
+			unpack_light(entry.light),
+			unpack_light(chunk->lightmap.map[entry.index])
+		);
+		// light spread to neighbours is less by 1
+		const uint32_t spreadLight = (
+			(source | BYTES_HIGH_BIT) - BYTES_ONE
+		) & 0x0F0F0F0F;
+
+		forEachNeighbour(entry, [=](Chunk* chunk, uint32_t slot, uint index) {
+			touch(chunk);
+
+			if (!lightPassing[chunk->voxels[index].id]) {
+				return;
+			}
+			auto& map = chunk->lightmap.map;
+			uint32_t light = unpack_light(map[index]);
+			// channels where light + 2 <= source
+			uint32_t mask = bytes_mask(
+				bytes_ge(source, light + BYTES_ONE * 2)
+			);
+			if (mask) {
+				uint32_t spread = spreadLight & mask;
+				map.set(index, pack_light((light & ~mask) | spread));
+				chunk->setUnsavedLights(true);
+				addqueue.push(lightentry {
+					slot, index, pack_light(spread)
+				});
+			}
+		}, [](int, int) {});
+	}
+	return count;
+}
+
+std::vector<glm::ivec2> LightSolver::takeUnreachedChunks() {
+	std::vector<glm::ivec2> taken;
+	taken.swap(unreachedChunks);
+	return taken;
+}
+
+void LightSolver::solve(){
+	solveRemovals(SIZE_MAX);
+	solveAdditions(SIZE_MAX);
+	settle();
+}
+
+void LightSolver::solveRemovals(){
+	solveRemovals(SIZE_MAX);
+}
+
+bool LightSolver::solve(size_t maxEntries){
+	size_t count = solveRemovals(maxEntries);
+	solveAdditions(maxEntries - count);
+	if (isSolved()) {
+		settle();
+		return true;
 	}
+	return false;
 }
@@ -1,31 +1,103 @@
 #ifndef LIGHTING_LIGHTSOLVER_H_
 #define LIGHTING_LIGHTSOLVER_H_
 
-#include <queue>
+#include <vector>
+#include <stdint.h>
+#include <glm/glm.hpp>
 
+#include "../typedefs.h"
+#include "../util/RingBuffer.h"
+
+class Chunk;
 class Chunks;
 class ContentIndices;
 
 struct lightentry {
-	int x;
-	int y;
-	int z;
-	unsigned char light;
+	/// @brief Index of the voxel chunk in the chunks matrix
+	/// (see Chunks::indexOf)
+	uint32_t slot;
+	/// @brief Index of the voxel in the chunk (see vox_index)
+	uint32_t index;
+	/// @brief Packed light of the channels the entry is queued for
+	/// (other channels are zero)
+	light_t light;
 };
 
+/// @brief Breadth-first light propagation of all four channels
+/// (R, G, B, S) at once. Channels are independent: result is the same
+/// as of propagating each channel separately
 class LightSolver {
-	std::queue<lightentry> addqueue;
-	std::queue<lightentry> remqueue;
+	util::RingBuffer<lightentry> addqueue;
+	util::RingBuffer<lightentry> remqueue;
 	const ContentIndices* const contentIds;
 	Chunks* chunks;
-	int channel;
+	/// @brief Coords of chunks marked light-dirty while solving
+	std::vector<glm::ivec2> dirtyChunks;
+	/// @brief Coords of not loaded chunks block light removal did not
+	/// spread to (see takeUnreachedChunks)
+	std::vector<glm::ivec2> unreachedChunks;
+
+	/// @brief Mark chunk modified and light-dirty
+	inline void touch(Chunk* chunk);
+	/// @brief Clear light-dirty flag of the chunks touched
+	void settle();
+
+	/// @return number of entries processed
+	size_t solveRemovals(size_t maxEntries);
+	/// @return number of entries processed
+	size_t solveAdditions(size_t maxEntries);
+
+	/// @brief Get the voxel chunk and the queue entry pointing to the voxel
+	/// @return chunk or nullptr if not loaded
+	Chunk* locate(int x, int y, int z, lightentry& entry);
+
+	/// @brief Call func(chunk, slot, index) for each loaded neighbour
+	/// of the entry voxel (none if the entry chunk is unloaded) and
+	/// unreached(cx, cz) for each adjacent chunk not loaded. Chunks matrix
+	/// is accessed at chunk borders only
+	template<class F, class U>
+	inline void forEachNeighbour(
+		const lightentry& entry, const F& func, const U& unreached
+	);
 public:
-	LightSolver(const ContentIndices* contentIds, Chunks* chunks, int channel);
+	/// @brief Mask of all channels of a packed light
+	static constexpr light_t ALL_CHANNELS = 0xFFFF;
+
+	LightSolver(const ContentIndices* contentIds, Chunks* chunks);
+
+	/// @brief Spread current light of the voxel
+	/// @param mask packed mask of channels to spread
+	void add(int x, int y, int z, light_t mask=ALL_CHANNELS);
 
-	void add(int x, int y, int z);
-	void add(int x, int y, int z, int emission);
-	void remove(int x, int y, int z);
+	/// @brief Set light of the voxel and spread it.
+	/// Channels with value 1 or less are not affected
+	/// @param light packed light (see Lightmap::combine)
+	void set(int x, int y, int z, light_t light);
+
+	/// @brief Remove light of the voxel and light it spread
+	/// @param mask packed mask of channels to remove
+	void remove(int x, int y, int z, light_t mask=ALL_CHANNELS);
+
+	/// @brief Process all queued entries
 	void solve();
+
+	/// @brief Process queued light removal only. Light spread queued
+	/// is left for the next solve
+	void solveRemovals();
+
+	/// @brief Process up to maxEntries queued entries (removals first).
+	/// Chunks touched stay light-dirty until all entries are processed
+	/// @return true if all entries are processed
+	bool solve(size_t maxEntries);
+
+	/// @brief Get coords of not loaded chunks block light removal did
+	/// not spread to since the previous call. Lights caches of the chunks
+	/// may keep the light removed
+	std::vector<glm::ivec2> takeUnreachedChunks();
+
+	inline bool isSolved() const {
+		return remqueue.empty() && addqueue.empty();
+	}
 };
 
 #endif /* LIGHTING_LIGHTSOLVER_H_ */
@@ -1,4 +1,5 @@
 #include <memory>
+#include <algorithm>
 
 #include "Lighting.h"
 #include "LightSolver.h"
@@ -6,107 +7,199 @@
 #include "../content/Content.h"
 #include "../voxels/Chunks.h"
 #include "../voxels/Chunk.h"
+#include "../voxels/ChunkCursor.h"
 #include "../voxels/voxel.h"
 #include "../voxels/Block.h"
 #include "../constants.h"
 #include "../typedefs.h"
 #include "../util/timeutil.h"
 
+std::atomic<size_t> Lighting::chunksLighted = 0;
+
+/// @brief Packed light masks of the channels
+static constexpr light_t RGB_MASK = Lightmap::combine(0xF, 0xF, 0xF, 0);
+static constexpr light_t SKY_MASK = Lightmap::combine(0, 0, 0, 0xF);
+/// @brief Number of queue entries processed between time checks
+static constexpr size_t UPDATE_STEP_ENTRIES = 1024;
+
 Lighting::Lighting(const Content* content, Chunks* chunks) 
 	     : content(content), chunks(chunks) {
-	auto indices = content->getIndices();
-	solverR = std::make_unique<LightSolver>(indices, chunks, 0);
-	solverG = std::make_unique<LightSolver>(indices, chunks, 1);
-	solverB = std::make_unique<LightSolver>(indices, chunks, 2);
-	solverS = std::make_unique<LightSolver>(indices, chunks, 3);
+	solver = std::make_unique<LightSolver>(content->getIndices(), chunks);
 }
 
 Lighting::~Lighting(){
 }
 
-void Lighting::clear(){
-	for (unsigned int index = 0; index < chunks->volume; index++){
-		auto chunk = chunks->chunks[index];
-		if (chunk == nullptr)
-			continue;
-		Lightmap& lightmap = chunk->lightmap;
-		for (int i = 0; i < CHUNK_VOL; i++){
-			lightmap.map[i] = 0;
-		}
-	}
-}
-
-void Lighting::prebuildSkyLight(Chunk* chunk, const ContentIndices* indices){
-	auto* blockDefs = indices->getBlockDefs();
+void Lighting::prebuildSkyLight(Chunk* chunk){
+    auto& lights = chunk->lightmap.map;
 
+    // y of the highest not sky light passing block of each column or -1
+    const int16_t* tops = chunk->heightmap.skyLight;
 	int highestPoint = 0;
-	for (int z = 0; z < CHUNK_D; z++){
-		for (int x = 0; x < CHUNK_W; x++){
-			for (int y = CHUNK_H-1; y >= 0; y--){
-                int index = (y * CHUNK_D + z) * CHUNK_W + x;
-				voxel& vox = chunk->voxels[index];
-				const Block* block = blockDefs[vox.id];
-				if (!block->skyLightPassing) {
-					if (highestPoint < y)
-						highestPoint = y;
-					break;
-				}
-				chunk->lightmap.setS(x,y,z, 15);
-			}
-		}
+	for (int i = 0; i < CHUNK_D * CHUNK_W; i++){
+        highestPoint = std::max(highestPoint, int(tops[i]));
 	}
+    // sections above all columns are lit entirely
+    int litSections = CHUNK_SECTIONS;
+    for (int s = CHUNK_SECTIONS-1; s >= 0; s--) {
+        if (s * CHUNK_SECTION_H <= highestPoint || !lights.isUniform(s)) {
+            break;
+        }
+        light_t light = lights.getUniform(s);
+        lights.fillSection(s, (light & 0x0FFF) | Lightmap::combine(0, 0, 0, 15));
+        litSections = s;
+    }
+    int litBottom = litSections * CHUNK_SECTION_H;
+    int lowestTop = *std::min_element(tops, tops + CHUNK_D * CHUNK_W);
+    // layers are lit row by row (index of column in a layer row is the 
+    // same as in the heightmap)
+    for (int y = lowestTop + 1; y < litBottom; y++) {
+        int section = y / CHUNK_SECTION_H;
+        if (lights.isUniform(section) && 
+            Lightmap::extract(lights.getUniform(section), 3) == 15) {
+            y = (section + 1) * CHUNK_SECTION_H - 1;
+            continue;
+        }
+        light_t* row = &lights.getWriteable(vox_index(0, y, 0));
+        for (int i = 0; i < CHUNK_D * CHUNK_W; i++) {
+            row[i] |= tops[i] < y ? SKY_MASK : 0;
+        }
+    }
 	if (highestPoint < CHUNK_H-1)
 		highestPoint++;
 	chunk->lightmap.highestPoint = highestPoint;
 }
 
+/// @return true if sky light of the voxel is bright enough to spread
+/// to any of its neighbours
+static bool can_spread_sky(
+	ChunkCursor& cursor, const ubyte* lightPassing, int x, int y, int z
+) {
+	static const int offsets[6][3] {
+		{0, 1, 0}, {0, -1, 0}, {1, 0, 0}, {-1, 0, 0}, {0, 0, 1}, {0, 0, -1}
+	};
+	cursor.moveTo(x, y, z);
+	int light = cursor.currentLight(3);
+	if (light <= 1) {
+		return false;
+	}
+	for (const auto& offset : offsets) {
+		const voxel* vox = cursor.neighbour(offset[0], offset[1], offset[2]);
+		if (vox && lightPassing[vox->id] && 
+			cursor.neighbourLight(offset[0], offset[1], offset[2], 3) + 2 <= light) {
+			return true;
+		}
+	}
+	return false;
+}
+
 void Lighting::buildSkyLight(int cx, int cz){
-	const Block* const* blockDefs = content->getIndices()->getBlockDefs();
+	const ubyte* lightPassing = content->getIndices()->getBlockProps().lightPassing.data();
 
 	Chunk* chunk = chunks->getChunk(cx, cz);
+	const auto& voxels = chunk->voxels;
+	const auto& lights = chunk->lightmap.map;
+
+	// the highest voxel of each column not lit from above or -1:
+	// it and all voxels below may get sky light from the neighbours
+	int shaded[CHUNK_D * CHUNK_W];
 	for (int z = 0; z < CHUNK_D; z++){
 		for (int x = 0; x < CHUNK_W; x++){
+			int top = -1;
 			for (int y = chunk->lightmap.highestPoint; y >= 0; y--){
-				int gx = x + cx * CHUNK_W;
-				int gz = z + cz * CHUNK_D;
-				while (y > 0 && !blockDefs[chunk->voxels[vox_index(x, y, z)].id]->lightPassing) {
+				while (y > 0 && !lightPassing[voxels[vox_index(x, y, z)].id]) {
 					y--;
 				}
-				if (chunk->lightmap.getS(x, y, z) != 15) {
-					solverS->add(gx,y+1,gz);
-					for (; y >= 0; y--){
-						solverS->add(gx+1,y,gz);
-						solverS->add(gx-1,y,gz);
-						solverS->add(gx,y,gz+1);
-						solverS->add(gx,y,gz-1);
-					}
+				if (Lightmap::extract(lights[vox_index(x, y, z)], 3) != 15) {
+					top = y;
+					break;
 				}
 			}
+			shaded[z * CHUNK_W + x] = top;
+		}
+	}
+
+	// only voxels able to spread light are queued
+	ChunkCursor cursor(*chunks);
+	auto seed = [&](int x, int y, int z) {
+		if (can_spread_sky(cursor, lightPassing, x, y, z)) {
+			solver->add(x, y, z, SKY_MASK);
+		}
+	};
+	auto getShaded = [&shaded](int x, int z) {
+		if (x < 0 || z < 0 || x >= CHUNK_W || z >= CHUNK_D) {
+			return -1;
+		}
+		return shaded[z * CHUNK_W + x];
+	};
+	int gx0 = cx * CHUNK_W;
+	int gz0 = cz * CHUNK_D;
+	for (int z = 0; z < CHUNK_D; z++){
+		for (int x = 0; x < CHUNK_W; x++){
+			int top = shaded[z * CHUNK_W + x];
+			if (top >= 0) {
+				seed(gx0 + x, top + 1, gz0 + z);
+			}
 		}
 	}
-	solverS->solve();
+	// columns around the shaded ones including the neighbour chunks 
+	// borders, each voxel is checked once
+	for (int z = -1; z <= CHUNK_D; z++){
+		for (int x = -1; x <= CHUNK_W; x++){
+			int top = std::max(
+				std::max(getShaded(x-1, z), getShaded(x+1, z)),
+				std::max(getShaded(x, z-1), getShaded(x, z+1))
+			);
+			int gx = gx0 + x;
+			int gz = gz0 + z;
+			Chunk* column = cursor.getChunkByVoxel(gx, 0, gz);
+			if (column == nullptr) {
+				continue;
+			}
+			const auto& columnLights = column->lightmap.map;
+			for (int y = 0; y <= top; y++) {
+				// sections having no sky light to spread
+				int section = y / CHUNK_SECTION_H;
+				if (columnLights.isUniform(section) && 
+					Lightmap::extract(columnLights.getUniform(section), 3) <= 1) {
+					y = (section + 1) * CHUNK_SECTION_H - 1;
+					continue;
+				}
+				seed(gx, y, gz);
+			}
+		}
+	}
+	solver->solve();
 }
 
 void Lighting::onChunkLoaded(int cx, int cz, bool expand){
-    LightSolver* solverR = this->solverR.get();
-    LightSolver* solverG = this->solverG.get();
-    LightSolver* solverB = this->solverB.get();
-    LightSolver* solverS = this->solverS.get();
+    LightSolver* solver = this->solver.get();
 
 	const Block* const* blockDefs = content->getIndices()->getBlockDefs();
+	const ubyte* emissive = content->getIndices()->getBlockProps().emissive.data();
 	const Chunk* chunk = chunks->getChunk(cx, cz);
 
 	for (uint y = 0; y < CHUNK_H; y++){
+        uint section = y / CHUNK_SECTION_H;
+        // uniform sections of not emissive blocks have no light sources
+        if (chunk->voxels.isUniform(section) && 
+            !emissive[chunk->voxels.getUniform(section).id]) {
+            y = (section + 1) * CHUNK_SECTION_H - 1;
+            continue;
+        }
 		for (uint z = 0; z < CHUNK_D; z++){
 			for (uint x = 0; x < CHUNK_W; x++){
 				const voxel& vox = chunk->voxels[(y * CHUNK_D + z) * CHUNK_W + x];
-				const Block* block = blockDefs[vox.id];
-				int gx = x + cx * CHUNK_W;
-				int gz = z + cz * CHUNK_D;
-				if (block->rt.emissive){
-					solverR->add(gx,y,gz,block->emission[0]);
-					solverG->add(gx,y,gz,block->emission[1]);
-					solverB->add(gx,y,gz,block->emission[2]);
+				if (emissive[vox.id]){
+					const Block* block = blockDefs[vox.id];
+					int gx = x + cx * CHUNK_W;
+					int gz = z + cz * CHUNK_D;
+					solver->set(gx,y,gz, Lightmap::combine(
+						block->emission[0], 
+						block->emission[1], 
+						block->emission[2], 
+						0
+					));
 				}
 			}
 		}
@@ -120,10 +213,7 @@ void Lighting::onChunkLoaded(int cx, int cz, bool expand){
 					int gz = z + cz * CHUNK_D;
 					int rgbs = chunk->lightmap.get(x, y, z);
 					if (rgbs){
-						solverR->add(gx,y,gz, Lightmap::extract(rgbs, 0));
-						solverG->add(gx,y,gz, Lightmap::extract(rgbs, 1));
-						solverB->add(gx,y,gz, Lightmap::extract(rgbs, 2));
-						solverS->add(gx,y,gz, Lightmap::extract(rgbs, 3));
+						solver->set(gx,y,gz, rgbs);
 					}
 				}
 			}
@@ -135,71 +225,147 @@ void Lighting::onChunkLoaded(int cx, int cz, bool expand){
 					int gz = z + cz * CHUNK_D;
 					int rgbs = chunk->lightmap.get(x, y, z);
 					if (rgbs){
-						solverR->add(gx,y,gz, Lightmap::extract(rgbs, 0));
-						solverG->add(gx,y,gz, Lightmap::extract(rgbs, 1));
-						solverB->add(gx,y,gz, Lightmap::extract(rgbs, 2));
-						solverS->add(gx,y,gz, Lightmap::extract(rgbs, 3));
+						solver->set(gx,y,gz, rgbs);
 					}
 				}
 			}
 		}
 	}
-	solverR->solve();
-	solverG->solve();
-	solverB->solve();
-	solverS->solve();
+	solver->solve();
+	chunksLighted++;
 }
 
-void Lighting::onBlockSet(int x, int y, int z, blockid_t id){
-	Block* block = content->getIndices()->getBlockDef(id);
-	solverR->remove(x,y,z);
-	solverG->remove(x,y,z);
-	solverB->remove(x,y,z);
+void Lighting::onCachedChunkLoaded(int cx, int cz){
+	const Chunk* chunk = chunks->getChunk(cx, cz);
+	const auto& lights = chunk->lightmap.map;
 
+	// light inside the chunk is solved already, so only block light 
+	// of the border voxels may spread further
+	auto expand = [&](int x, int y, int z) {
+		light_t rgb = lights[vox_index(x, y, z)] & RGB_MASK;
+		if (rgb) {
+			solver->set(x + cx * CHUNK_W, y, z + cz * CHUNK_D, rgb);
+		}
+	};
+	for (int section = 0; section < CHUNK_SECTIONS; section++) {
+		if (lights.isUniform(section) && 
+			(lights.getUniform(section) & RGB_MASK) == 0) {
+			continue;
+		}
+		int top = (section + 1) * CHUNK_SECTION_H;
+		for (int y = section * CHUNK_SECTION_H; y < top; y++) {
+			for (int z = 0; z < CHUNK_D; z++) {
+				expand(0, y, z);
+				expand(CHUNK_W-1, y, z);
+			}
+			for (int x = 1; x < CHUNK_W-1; x++) {
+				expand(x, y, 0);
+				expand(x, y, CHUNK_D-1);
+			}
+		}
+	}
+	solver->solve();
+	chunksLighted++;
+}
+
+void Lighting::removeLights(int x, int y, int z, blockid_t id){
+	const Block* block = content->getIndices()->getBlockDef(id);
+	solver->remove(x,y,z, RGB_MASK);
+	if (id != 0 && !block->skyLightPassing){
+		solver->remove(x,y,z, SKY_MASK);
+		for (int i = y-1; i >= 0; i--){
+			solver->remove(x,i,z, SKY_MASK);
+			if (i == 0 || chunks->get(x,i-1,z)->id != 0){
+				break;
+			}
+		}
+	}
+}
+
+void Lighting::addLights(int x, int y, int z, blockid_t id){
+	const Block* block = content->getIndices()->getBlockDef(id);
 	if (id == 0){
-		solverR->solve();
-		solverG->solve();
-		solverB->solve();
 		if (chunks->getLight(x,y+1,z, 3) == 0xF){
 			for (int i = y; i >= 0; i--){
-				voxel* vox = chunks->get(x,i,z);
+				const voxel* vox = chunks->get(x,i,z);
 				if ((vox == nullptr || vox->id != 0) && block->skyLightPassing)
 					break;
-				solverS->add(x,i,z, 0xF);
+				solver->set(x,i,z, SKY_MASK);
 			}
 		}
-		solverR->add(x,y+1,z); solverG->add(x,y+1,z); solverB->add(x,y+1,z); solverS->add(x,y+1,z);
-		solverR->add(x,y-1,z); solverG->add(x,y-1,z); solverB->add(x,y-1,z); solverS->add(x,y-1,z);
-		solverR->add(x+1,y,z); solverG->add(x+1,y,z); solverB->add(x+1,y,z); solverS->add(x+1,y,z);
-		solverR->add(x-1,y,z); solverG->add(x-1,y,z); solverB->add(x-1,y,z); solverS->add(x-1,y,z);
-		solverR->add(x,y,z+1); solverG->add(x,y,z+1); solverB->add(x,y,z+1); solverS->add(x,y,z+1);
-		solverR->add(x,y,z-1); solverG->add(x,y,z-1); solverB->add(x,y,z-1); solverS->add(x,y,z-1);
-		solverR->solve();
-		solverG->solve();
-		solverB->solve();
-		solverS->solve();
-	} else {
-		if (!block->skyLightPassing){
-			solverS->remove(x,y,z);
-			for (int i = y-1; i >= 0; i--){
-				solverS->remove(x,i,z);
-				if (i == 0 || chunks->get(x,i-1,z)->id != 0){
-					break;
-				}
-			}
-			solverS->solve();
+		solver->add(x,y+1,z);
+		solver->add(x,y-1,z);
+		solver->add(x+1,y,z);
+		solver->add(x-1,y,z);
+		solver->add(x,y,z+1);
+		solver->add(x,y,z-1);
+	} else if (block->emission[0] || block->emission[1] || block->emission[2]){
+		solver->set(x,y,z, Lightmap::combine(
+			block->emission[0], 
+			block->emission[1], 
+			block->emission[2], 
+			0
+		));
+	}
+}
+
+void Lighting::onBlockSet(int x, int y, int z, blockid_t id){
+	if (batchDepth) {
+		batchedBlocks.emplace_back(x, y, z);
+		return;
+	}
+	removeLights(x, y, z, id);
+	solver->solveRemovals();
+	addLights(x, y, z, id);
+}
+
+void Lighting::beginBatch() {
+	batchDepth++;
+}
+
+void Lighting::endBatch() {
+	if (--batchDepth > 0 || batchedBlocks.empty()) {
+		return;
+	}
+	// all removals are solved before spreading any light, so light of
+	// removed sources does not spread over the other changed blocks.
+	// Blocks are relit according to their final state
+	for (const auto& pos : batchedBlocks) {
+		if (const voxel* vox = chunks->get(pos.x, pos.y, pos.z)) {
+			removeLights(pos.x, pos.y, pos.z, vox->id);
+		}
+	}
+	solver->solveRemovals();
+	for (const auto& pos : batchedBlocks) {
+		if (const voxel* vox = chunks->get(pos.x, pos.y, pos.z)) {
+			addLights(pos.x, pos.y, pos.z, vox->id);
 		}
-		solverR->solve();
-		solverG->solve();
-		solverB->solve();
+	}
+	batchedBlocks.clear();
+}
 
-		if (block->emission[0] || block->emission[1] || block->emission[2]){
-			solverR->add(x,y,z,block->emission[0]);
-			solverG->add(x,y,z,block->emission[1]);
-			solverB->add(x,y,z,block->emission[2]);
-			solverR->solve();
-			solverG->solve();
-			solverB->solve();
+bool Lighting::update(int64_t maxDuration) {
+	timeutil::Timer timer;
+	while (!solver->solve(UPDATE_STEP_ENTRIES)) {
+		if (timer.stop() >= maxDuration) {
+			return false;
 		}
 	}
+	return true;
+}
+
+void Lighting::onChunkUnloaded(const Chunk* chunk) {
+	// lights of the chunk are saved to the lights cache, so light
+	// queued is spread before the chunk leaves the matrix
+	if (!solver->isSolved()) {
+		solver->solve();
+	}
+}
+
+void Lighting::flush() {
+	solver->solve();
+}
+
+std::vector<glm::ivec2> Lighting::takeStaleCaches() {
+	return solver->takeUnreachedChunks();
 }
@@ -1,10 +1,14 @@
 #ifndef LIGHTING_LIGHTING_H_
 #define LIGHTING_LIGHTING_H_
 
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+
 #include "../typedefs.h"
 
 class Content;
-class ContentIndices;
 class Chunk;
 class Chunks;
 class LightSolver;
@@ -12,20 +16,82 @@ class LightSolver;
 class Lighting {
 	const Content* const content;
 	Chunks* chunks;
-	std::unique_ptr<LightSolver> solverR;
-	std::unique_ptr<LightSolver> solverG;
-	std::unique_ptr<LightSolver> solverB;
-	std::unique_ptr<LightSolver> solverS;
+	/// @brief Solver of all channels at once
+	std::unique_ptr<LightSolver> solver;
+	/// @brief Number of not ended batches
+	int batchDepth = 0;
+	/// @brief Positions of blocks set while a batch is open
+	std::vector<glm::ivec3> batchedBlocks;
+
+	/// @brief Queue removal of the light the block set blocks
+	void removeLights(int x, int y, int z, blockid_t id);
+	/// @brief Queue light the block set lets through or emits
+	void addLights(int x, int y, int z, blockid_t id);
 public:
+	/// @brief Number of chunks lit with onChunkLoaded by all instances
+	static std::atomic<size_t> chunksLighted;
+
 	Lighting(const Content* content, Chunks* chunks);
 	~Lighting();
 
-	void clear();
 	void buildSkyLight(int cx, int cz);
+	/// @brief Calculate initial lights of the chunk. Modifies lights of 
+	/// the chunk and its 8 neighbours only, so chunks with not overlapping
+	/// 3x3 neighbourhoods may be lit by different instances concurrently
 	void onChunkLoaded(int cx, int cz, bool expand);
+	/// @brief Spread block light of the chunk loaded with lights cache
+	/// of all channels to the neighbours. Light sources are not scanned,
+	/// same chunks as of onChunkLoaded are modified
+	void onCachedChunkLoaded(int cx, int cz);
+	/// @brief Spread queued light before the chunk leaves the matrix,
+	/// so half-spread light is not saved to its lights cache. Nothing is
+	/// done if no light is queued: queued entries stay in their places
+	/// when the matrix is translated
+	void onChunkUnloaded(const Chunk* chunk);
+	/// @brief Update lights after the block set (or queue the update 
+	/// if a batch is open). Light removal is solved immediately, spread
+	/// of light is queued for update or flush
 	void onBlockSet(int x, int y, int z, blockid_t id);
 
-	static void prebuildSkyLight(Chunk* chunk, const ContentIndices* indices);
+	/// @brief Spread queued light for up to maxDuration microseconds.
+	/// Chunks affected stay light-dirty until all light is spread
+	/// @return true if all queued light is spread
+	bool update(int64_t maxDuration);
+
+	/// @brief Spread all queued light (e.g. before saving chunks)
+	void flush();
+
+	/// @brief Get coords of not loaded chunks block light removal did not
+	/// reach since the previous call. Their full lights caches may have
+	/// the removed light and must not be used
+	std::vector<glm::ivec2> takeStaleCaches();
+
+	/// @brief Defer lights update of blocks set until the batch end, 
+	/// then relight all of them at once. Batches may be nested:
+	/// lights are updated when the outermost one ends
+	void beginBatch();
+	void endBatch();
+
+	/// @brief Fill sky light above columns heights (chunk heightmap 
+	/// must be up to date)
+	static void prebuildSkyLight(Chunk* chunk);
+};
+
+/// @brief Lights batch open while the object exists
+/// (see Lighting::beginBatch)
+class LightingBatch {
+	Lighting* lighting;
+public:
+	LightingBatch(Lighting* lighting) : lighting(lighting) {
+		lighting->beginBatch();
+	}
+
+	LightingBatch(const LightingBatch&) = delete;
+	LightingBatch& operator=(const LightingBatch&) = delete;
+
+	~LightingBatch() {
+		lighting->endBatch();
+	}
 };
 
 #endif /* LIGHTING_LIGHTING_H_ */
@@ -4,13 +4,11 @@
 #include "../util/data_io.h"
 
 void Lightmap::set(const Lightmap* lightmap) {
-    set(lightmap->map);
+    map = lightmap->map;
 }
 
 void Lightmap::set(const light_t* map) {
-    for (size_t i = 0; i < CHUNK_VOL; i++) {
-        this->map[i] = map[i];
-    }
+    this->map.set(map);
 }
 
 static_assert(sizeof(light_t) == 2, "replace dataio calls to new light_t");
@@ -32,3 +30,29 @@ light_t* Lightmap::decode(ubyte* buffer) {
     } 
     return lights;
 }
+
+ubyte* Lightmap::encodeFull() const {
+    ubyte* buffer = new ubyte[LIGHTMAP_FULL_DATA_LEN];
+    buffer[0] = LIGHTMAP_FORMAT_FULL;
+    ubyte* low = buffer + 1;
+    ubyte* high = low + CHUNK_VOL;
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        light_t light = map[i];
+        low[i] = light & 0xFF;
+        high[i] = light >> 8;
+    }
+    return buffer;
+}
+
+light_t* Lightmap::decodeFull(const ubyte* buffer) {
+    if (buffer[0] != LIGHTMAP_FORMAT_FULL) {
+        return nullptr;
+    }
+    const ubyte* low = buffer + 1;
+    const ubyte* high = low + CHUNK_VOL;
+    light_t* lights = new light_t[CHUNK_VOL];
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        lights[i] = low[i] | (high[i] << 8);
+    }
+    return lights;
+}
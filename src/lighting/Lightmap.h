@@ -3,13 +3,28 @@
 
 #include "../constants.h"
 #include "../typedefs.h"
+#include "../util/SectionedArray.h"
 
+/// @brief Length of sky light data (see Lightmap::encode)
 inline constexpr int LIGHTMAP_DATA_LEN = CHUNK_VOL/2;
+/// @brief Full lights data format (first byte of the data). 
+/// Sky light data has no format byte
+inline constexpr ubyte LIGHTMAP_FORMAT_FULL = 1;
+/// @brief Length of full lights data (see Lightmap::encodeFull)
+inline constexpr int LIGHTMAP_FULL_DATA_LEN = 1 + CHUNK_VOL*2;
+
+using chunk_lights = util::SectionedArray<light_t, CHUNK_SECTION_VOL, CHUNK_SECTIONS>;
 
 // Lichtkarte
 class Lightmap {
+    inline void setChannel(int index, int shift, int value) {
+        light_t light = map[index];
+        map.set(index, light_t((light & ~(0xF << shift)) | (value << shift)));
+    }
 public:
-    light_t map[CHUNK_VOL] {};
+    /// @brief Lights of vertical sections with the same light 
+    /// everywhere are not allocated
+    chunk_lights map;
     int highestPoint = 0;
 
     void set(const Lightmap* lightmap);
@@ -41,36 +56,23 @@ public:
     }
 
     inline void setR(int x, int y, int z, int value){
-        const int index = y*CHUNK_D*CHUNK_W+z*CHUNK_W+x;
-        map[index] = (map[index] & 0xFFF0) | value;
+        setChannel(y*CHUNK_D*CHUNK_W+z*CHUNK_W+x, 0, value);
     }
 
     inline void setG(int x, int y, int z, int value){
-        const int index = y*CHUNK_D*CHUNK_W+z*CHUNK_W+x;
-        map[index] = (map[index] & 0xFF0F) | (value << 4);
+        setChannel(y*CHUNK_D*CHUNK_W+z*CHUNK_W+x, 4, value);
     }
 
     inline void setB(int x, int y, int z, int value){
-        const int index = y*CHUNK_D*CHUNK_W+z*CHUNK_W+x;
-        map[index] = (map[index] & 0xF0FF) | (value << 8);
+        setChannel(y*CHUNK_D*CHUNK_W+z*CHUNK_W+x, 8, value);
     }
 
     inline void setS(int x, int y, int z, int value){
-        const int index = y*CHUNK_D*CHUNK_W+z*CHUNK_W+x;
-        map[index] = (map[index] & 0x0FFF) | (value << 12);
+        setChannel(y*CHUNK_D*CHUNK_W+z*CHUNK_W+x, 12, value);
     }
 
     inline void set(int x, int y, int z, int channel, int value){
-        const int index = y*CHUNK_D*CHUNK_W+z*CHUNK_W+x;
-        map[index] = (map[index] & (0xFFFF & (~(0xF << (channel*4))))) | (value << (channel << 2));
-    }
-
-    inline const light_t* getLights() const {
-        return map;
-    }
-
-    inline light_t* getLightsWriteable() {
-        return map;
+        setChannel(y*CHUNK_D*CHUNK_W+z*CHUNK_W+x, channel << 2, value);
     }
 
     static constexpr light_t combine(int r, int g, int b, int s) {
@@ -81,8 +83,18 @@ public:
         return (light >> (channel << 2)) & 0xF;
     }
 
+    /// @brief Encode sky light only (4 bits per voxel)
+    /// @return LIGHTMAP_DATA_LEN bytes
     ubyte* encode() const;
     static light_t* decode(ubyte* buffer);
+
+    /// @brief Encode all channels: format byte, then low bytes of all
+    /// lights, then high bytes. Planes of (R, G) and (B, S) consist of
+    /// long runs of the same bytes, so the data is compressed well
+    /// @return LIGHTMAP_FULL_DATA_LEN bytes
+    ubyte* encodeFull() const;
+    /// @return decoded lights or nullptr if format is not supported
+    static light_t* decodeFull(const ubyte* buffer);
 };
 
 #endif /* LIGHTING_LIGHTMAP_H_ */
@@ -71,6 +71,8 @@ void BlocksController::updateSides(int x, int y, int z) {
 }
 
 void BlocksController::breakBlock(Player* player, const Block* def, int x, int y, int z) {
+    // blocks broken by the update cascade are relit at once
+    LightingBatch batch(lighting);
     chunks->set(x,y,z, 0, 0);
     lighting->onBlockSet(x,y,z, 0);
     if (def->rt.funcsset.onbroken) {
@@ -80,7 +82,7 @@ void BlocksController::breakBlock(Player* player, const Block* def, int x, int y
 }
 
 void BlocksController::updateBlock(int x, int y, int z) {
-    voxel* vox = chunks->get(x, y, z);
+    const voxel* vox = chunks->get(x, y, z);
     if (vox == nullptr)
         return;
     const Block* def = level->content->getIndices()->getBlockDef(vox->id);
@@ -94,6 +96,8 @@ void BlocksController::updateBlock(int x, int y, int z) {
 }
 
 void BlocksController::update(float delta) {
+    // blocks set by the tick handlers are relit at once
+    LightingBatch batch(lighting);
     if (randTickClock.update(delta)) {
         randomTick(randTickClock.getPart(), randTickClock.getParts());
     }
@@ -122,6 +126,8 @@ void BlocksController::onBlocksTick(int tickid, int parts) {
 void BlocksController::randomTick(int tickid, int parts) {
     const int w = chunks->w;
     const int d = chunks->d;
+    const int ox = chunks->ox;
+    const int oz = chunks->oz;
     int segments = 4;
     int segheight = CHUNK_H / segments;
     auto indices = level->content->getIndices();
@@ -131,7 +137,7 @@ void BlocksController::randomTick(int tickid, int parts) {
             int index = z * w + x;
             if ((index + tickid) % parts != 0)
                 continue;
-            auto chunk = chunks->chunks[index];
+            auto chunk = chunks->getChunk(x+ox, z+oz);
             if (chunk == nullptr || !chunk->isLighted())
                 continue;
             for (int s = 0; s < segments; s++) {
@@ -2,13 +2,16 @@
 
 #include <limits.h>
 #include <memory>
+#include <thread>
 #include <iostream>
+#include <algorithm>
 
 #include "../content/Content.h"
 #include "../voxels/Block.h"
 #include "../voxels/Chunk.h"
 #include "../voxels/Chunks.h"
 #include "../voxels/ChunksStorage.h"
+#include "../voxels/ChunkPool.h"
 #include "../voxels/WorldGenerator.h"
 #include "../world/WorldGenerators.h"
 #include "../graphics/Mesh.h"
@@ -21,13 +24,61 @@
 
 const uint MAX_WORK_PER_FRAME = 64;
 const uint MIN_SURROUNDING = 9;
+/// @brief Max chunks being read from world files at the same time
+const uint MAX_REQUESTED_CHUNKS = 32;
+/// @brief Width of chunks strip read ahead of the loading zone
+const int READ_AHEAD_DISTANCE = 2;
+const uint MAX_LIGHTING_THREADS = 8;
+const uint MAX_GENERATOR_THREADS = 8;
+/// @brief Max chunks queued for generation or being generated
+const uint MAX_GENERATING_CHUNKS = 16;
+
+std::atomic<size_t> ChunksController::chunksGenerated = 0;
 
 ChunksController::ChunksController(Level* level, uint padding) 
     : level(level), 
 	  chunks(level->chunks.get()), 
-	  lighting(level->lighting.get()), 
+	  worldFiles(level->getWorld()->wfile.get()),
 	  padding(padding), 
-	  generator(WorldGenerators::createGenerator(level->getWorld()->getGenerator(), level->content)) {
+	  prevOx(chunks->ox),
+	  prevOz(chunks->oz),
+      worldGenerator(WorldGenerators::createGenerator(
+          level->getWorld()->getGenerator(), level->content
+      )) {
+    uint threads = std::thread::hardware_concurrency() / 2;
+    uint generatorThreads = std::max(1U, std::min(threads, MAX_GENERATOR_THREADS));
+    for (uint i = 0; i < generatorThreads; i++) {
+        generatorBuffers.push_back(std::make_unique<voxel[]>(CHUNK_VOL));
+    }
+    generator = std::make_unique<chunks_generator>(
+        "chunks generation",
+        [this](glm::ivec2& pos) {
+            return generateChunk(pos.x, pos.y);
+        },
+        generatorThreads
+    );
+
+    threads = std::max(1U, std::min(threads, MAX_LIGHTING_THREADS));
+    for (uint i = 0; i < threads; i++) {
+        lightings.push_back(std::make_unique<Lighting>(level->content, chunks));
+    }
+    lighter = std::make_unique<chunks_lighter>(
+        "chunks lighting",
+        [](light_task& task) {
+            auto& chunk = task.chunk;
+            if (chunk->isLoadedFullLights()) {
+                task.lighting->onCachedChunkLoaded(chunk->x, chunk->z);
+                return task;
+            }
+            bool lightsCache = chunk->isLoadedLights();
+            if (!lightsCache) {
+                task.lighting->buildSkyLight(chunk->x, chunk->z);
+            }
+            task.lighting->onChunkLoaded(chunk->x, chunk->z, !lightsCache);
+            return task;
+        },
+        threads
+    );
 }
 
 ChunksController::~ChunksController(){
@@ -36,6 +87,24 @@ ChunksController::~ChunksController(){
 void ChunksController::update(int64_t maxDuration) {
     int64_t mcstotal = 0;
 
+    readAhead();
+    worldFiles->trimRegionsCache();
+
+    // chunks left the loading zone are not needed anymore
+    int x1 = chunks->ox + int(padding);
+    int z1 = chunks->oz + int(padding);
+    int x2 = chunks->ox + int(chunks->w - padding);
+    int z2 = chunks->oz + int(chunks->d - padding);
+    worldFiles->cancelChunksOutside(x1, z1, x2 - x1, z2 - z1);
+    generator->removeJobs([=](const glm::ivec2& pos) {
+        if (pos.x < x1 || pos.y < z1 || pos.x >= x2 || pos.y >= z2) {
+            generatingChunks.erase(pos);
+            return true;
+        }
+        return false;
+    });
+    collectGenerated();
+
     for (uint i = 0; i < MAX_WORK_PER_FRAME; i++) {
 		timeutil::Timer timer;
         if (loadVisible()) {
@@ -48,25 +117,66 @@ void ChunksController::update(int64_t maxDuration) {
         }
         break;
     }
+    // at least one batch per frame, so lighting does not starve
+    // while chunks are being generated
+    do {
+        timeutil::Timer timer;
+        if (!buildLights()) {
+            break;
+        }
+        mcstotal += timer.stop();
+    } while (mcstotal < maxDuration * 1000);
+}
+
+void ChunksController::readAhead() {
+    int dx = chunks->ox - prevOx;
+    int dz = chunks->oz - prevOz;
+    prevOx = chunks->ox;
+    prevOz = chunks->oz;
+
+    // loading zone bounds
+    int x1 = chunks->ox + int(padding);
+    int z1 = chunks->oz + int(padding);
+    int x2 = chunks->ox + int(chunks->w - padding);
+    int z2 = chunks->oz + int(chunks->d - padding);
+    if (dx || dz) {
+        // strips of the previous position are behind now
+        worldFiles->cancelPrefetch();
+    }
+    if (dx) {
+        int x = dx > 0 ? x2 : x1 - READ_AHEAD_DISTANCE;
+        worldFiles->prefetchChunks(x, z1, READ_AHEAD_DISTANCE, z2 - z1);
+    }
+    if (dz) {
+        int z = dz > 0 ? z2 : z1 - READ_AHEAD_DISTANCE;
+        worldFiles->prefetchChunks(x1, z, x2 - x1, READ_AHEAD_DISTANCE);
+    }
 }
 
 bool ChunksController::loadVisible(){
+	loaded_chunk data;
+	if (worldFiles->pollChunk(data)) {
+		createChunk(data);
+		return true;
+	}
+
 	const int w = chunks->w;
 	const int d = chunks->d;
+	const int ox = chunks->ox;
+	const int oz = chunks->oz;
 
+	bool found = false;
 	int nearX = 0;
 	int nearZ = 0;
 	int minDistance = ((w-padding*2)/2)*((w-padding*2)/2);
 	for (uint z = padding; z < d-padding; z++){
 		for (uint x = padding; x < w-padding; x++){
-			int index = z * w + x;
-			auto chunk = chunks->chunks[index];
+			auto chunk = chunks->chunks[chunks->indexOf(x+ox, z+oz)];
 			if (chunk != nullptr){
-				if (chunk->isLoaded() && !chunk->isLighted()) {
-					if (buildLights(chunk)) {
-                        return true;
-                    }
-				}
+				continue;
+			}
+			if (worldFiles->isChunkRequested(x+ox, z+oz) ||
+				generatingChunks.find(glm::ivec2(x+ox, z+oz)) != generatingChunks.end()) {
 				continue;
 			}
 			int lx = x - w / 2;
@@ -76,59 +186,145 @@ bool ChunksController::loadVisible(){
 				minDistance = distance;
 				nearX = x;
 				nearZ = z;
+				found = true;
 			}
 		}
 	}
 
-	auto chunk = chunks->chunks[nearZ * w + nearX];
-	if (chunk != nullptr) {
+	if (!found || worldFiles->countRequestedChunks() >= MAX_REQUESTED_CHUNKS ||
+		generatingChunks.size() >= MAX_GENERATING_CHUNKS) {
 		return false;
 	}
-
-    const int ox = chunks->ox;
-	const int oz = chunks->oz;
-	createChunk(nearX+ox, nearZ+oz);
+	worldFiles->requestChunk(nearX+ox, nearZ+oz);
 	return true;
 }
 
-bool ChunksController::buildLights(std::shared_ptr<Chunk> chunk) {
-    int surrounding = 0;
+static bool is_surrounded(Chunks* chunks, const Chunk* chunk) {
+    uint surrounding = 0;
     for (int oz = -1; oz <= 1; oz++){
         for (int ox = -1; ox <= 1; ox++){
             if (chunks->getChunk(chunk->x+ox, chunk->z+oz))
                 surrounding++;
         }
     }
-    if (surrounding == MIN_SURROUNDING) {
-        bool lightsCache = chunk->isLoadedLights();
-        if (!lightsCache) {
-            lighting->buildSkyLight(chunk->x, chunk->z);
+    return surrounding == MIN_SURROUNDING;
+}
+
+bool ChunksController::buildLights() {
+    const int w = chunks->w;
+    const int d = chunks->d;
+    const int ox = chunks->ox;
+    const int oz = chunks->oz;
+
+    std::vector<std::shared_ptr<Chunk>> candidates;
+    for (uint z = padding; z < d-padding; z++){
+        for (uint x = padding; x < w-padding; x++){
+            const auto& chunk = chunks->chunks[chunks->indexOf(x+ox, z+oz)];
+            if (chunk && chunk->isLoaded() && !chunk->isLighted() && 
+                is_surrounded(chunks, chunk.get())) {
+                candidates.push_back(chunk);
+            }
         }
-        lighting->onChunkLoaded(chunk->x, chunk->z, !lightsCache);
-        chunk->setLighted(true);
-        return true;
     }
-    return false;
-}
+    if (candidates.empty()) {
+        return false;
+    }
+    // the nearest chunks become visible first
+    const int cx = ox + w / 2;
+    const int cz = oz + d / 2;
+    auto distance = [=](const std::shared_ptr<Chunk>& chunk) {
+        int dx = chunk->x - cx;
+        int dz = chunk->z - cz;
+        return dx * dx + dz * dz;
+    };
+    std::sort(candidates.begin(), candidates.end(), 
+        [&distance](const auto& a, const auto& b) {
+            return distance(a) < distance(b);
+        });
 
-void ChunksController::createChunk(int x, int z) {
-    auto chunk = level->chunksStorage->create(x, z);
-	chunks->putChunk(chunk);
+    // lighting a chunk modifies lights of its 3x3 neighbourhood only,
+    // so chunks at least 3 chunks apart may be lit concurrently
+    std::vector<const Chunk*> batch;
+    for (const auto& chunk : candidates) {
+        if (batch.size() == lightings.size()) {
+            break;
+        }
+        bool overlaps = std::any_of(batch.begin(), batch.end(),
+            [&chunk](const Chunk* other) {
+                return std::abs(chunk->x - other->x) < 3 && 
+                       std::abs(chunk->z - other->z) < 3;
+            });
+        if (overlaps) {
+            continue;
+        }
+        lighter->enqueueJob(light_task {chunk, lightings[batch.size()].get()});
+        batch.push_back(chunk.get());
+    }
+    lighter->waitAll();
+
+    // lit chunks are meshed when drawn the next time
+    light_task task;
+    while (lighter->pollResult(task)) {
+        task.chunk->setLighted(true);
+    }
+    return true;
+}
 
-	if (!chunk->isLoaded()) {
-		generator->generate(
-            chunk->voxels, x, z, 
-            level->world->getSeed()
-        );
-		chunk->setUnsaved(true);
+void ChunksController::createChunk(loaded_chunk& data) {
+	if (data.voxels == nullptr) {
+		glm::ivec2 pos (data.x, data.z);
+		generatingChunks.insert(pos);
+		generator->enqueueJob(pos);
+		return;
 	}
-	chunk->updateHeights();
+    auto chunk = level->chunksStorage->create(data);
+	chunk->updateHeights(level->content->getIndices());
 
 	if (!chunk->isLoadedLights()) {
-		Lighting::prebuildSkyLight(
-            chunk.get(), level->content->getIndices()
-        );
+		Lighting::prebuildSkyLight(chunk.get());
 	}
     chunk->setLoaded(true);
 	chunk->setReady(true);
+
+	// chunk is published when all its data is set: mesh threads
+	// read stored chunks
+	if (chunks->putChunk(chunk)) {
+		level->chunksStorage->store(chunk);
+	}
+}
+
+void ChunksController::collectGenerated() {
+    std::shared_ptr<Chunk> chunk;
+    while (generator->pollResult(chunk)) {
+        generatingChunks.erase(glm::ivec2(chunk->x, chunk->z));
+        // the matrix may have moved away while the chunk was generated
+        if (chunks->putChunk(chunk)) {
+            level->chunksStorage->store(chunk);
+        }
+    }
+}
+
+std::shared_ptr<Chunk> ChunksController::generateChunk(int x, int z) {
+    std::unique_ptr<voxel[]> buffer;
+    {
+        std::lock_guard<std::mutex> lock(generatorBuffersMutex);
+        buffer = std::move(generatorBuffers.back());
+        generatorBuffers.pop_back();
+    }
+    auto chunk = level->chunksStorage->getPool()->create(x, z);
+    generator_context context (x, z, level->world->getSeed());
+    worldGenerator->generate(buffer.get(), context);
+    chunk->voxels.set(buffer.get());
+    {
+        std::lock_guard<std::mutex> lock(generatorBuffersMutex);
+        generatorBuffers.push_back(std::move(buffer));
+    }
+    chunk->updateHeights(level->content->getIndices());
+    Lighting::prebuildSkyLight(chunk.get());
+
+    chunk->setUnsaved(true);
+    chunk->setLoaded(true);
+    chunk->setReady(true);
+    chunksGenerated++;
+    return chunk;
 }
@@ -1,29 +1,88 @@
 #ifndef VOXELS_CHUNKSCONTROLLER_H_
 #define VOXELS_CHUNKSCONTROLLER_H_
 
+#include <mutex>
+#include <atomic>
 #include <memory>
+#include <vector>
+#include <unordered_set>
+#include <glm/glm.hpp>
+#define GLM_ENABLE_EXPERIMENTAL
+#include "glm/gtx/hash.hpp"
+
 #include "../typedefs.h"
+#include "../util/ThreadPool.h"
 
 class Level;
 class Chunk;
 class Chunks;
 class Lighting;
 class WorldGenerator;
+class WorldFiles;
+struct loaded_chunk;
+struct voxel;
+
+/// @brief Initial lighting of a chunk done by a lighting worker
+struct light_task {
+    std::shared_ptr<Chunk> chunk;
+    /// @brief Lighting instance used by this task only
+    Lighting* lighting = nullptr;
+};
+
+using chunks_lighter = util::ThreadPool<light_task, light_task>;
+
+/// @brief Workers generating missing chunks (job is chunk position, 
+/// result is generated chunk not added to the level yet)
+using chunks_generator = util::ThreadPool<glm::ivec2, std::shared_ptr<Chunk>>;
 
 /// @brief ChunksController manages chunks dynamic loading/unloading
 class ChunksController {
 private:
     Level* level;
     Chunks* chunks;
-    Lighting* lighting;
+    WorldFiles* worldFiles;
     uint padding;
-    std::unique_ptr<WorldGenerator> generator;
+    /// @brief Chunks matrix position on the previous update
+    int prevOx, prevOz;
+    /// @brief World generator shared by the generation workers, so its
+    /// generate must be reentrant and use no global state (random, noise
+    /// tables). test/generators_determinism.cpp checks it for all
+    /// registered generators
+    std::unique_ptr<WorldGenerator> worldGenerator;
+    /// @brief Flat voxels buffers chunks are generated into, 
+    /// not used by the generation workers at the moment
+    std::vector<std::unique_ptr<voxel[]>> generatorBuffers;
+    std::mutex generatorBuffersMutex;
+    std::unique_ptr<chunks_generator> generator;
+    /// @brief Chunks queued or being generated
+    std::unordered_set<glm::ivec2> generatingChunks;
+    /// @brief Lighting instances for the lighting workers, 
+    /// one per task in a batch
+    std::vector<std::unique_ptr<Lighting>> lightings;
+    std::unique_ptr<chunks_lighter> lighter;
+
+    /// @brief Prefetch stored chunks ahead of the chunks matrix movement
+    void readAhead();
 
-    /// @brief Process one chunk: load it or calculate lights for it
+    /// @brief Process one chunk: create loaded one or request the nearest 
+    /// missing chunk
     bool loadVisible();
-    bool buildLights(std::shared_ptr<Chunk> chunk);
-    void createChunk(int x, int y);
+
+    /// @brief Light a batch of loaded chunks in parallel. Chunks lit 
+    /// at the same time have not overlapping 3x3 neighbourhoods
+    /// @return false if there are no chunks ready to be lit
+    bool buildLights();
+    /// @brief Add chunk read from the world files or enqueue 
+    /// its generation if chunk is not stored
+    void createChunk(loaded_chunk& data);
+    /// @brief Add generated chunks to the level, drop not needed anymore
+    void collectGenerated();
+    /// @brief Generate chunk voxels, heights and sky light (thread-safe)
+    std::shared_ptr<Chunk> generateChunk(int x, int z);
 public:
+    /// @brief Number of chunks generated by all instances
+    static std::atomic<size_t> chunksGenerated;
+
     ChunksController(Level* level, uint padding);
     ~ChunksController();
 
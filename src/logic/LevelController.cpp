@@ -5,9 +5,14 @@
 
 #include "scripting/scripting.h"
 #include "../interfaces/Object.h"
+#include "../lighting/Lighting.h"
+#include "../files/WorldFiles.h"
 
 #include <iostream>
 
+/// @brief Max time of the queued light spread per frame (microseconds)
+static constexpr int64_t LIGHTING_BUDGET = 2000;
+
 LevelController::LevelController(EngineSettings& settings, Level* level) 
     : settings(settings), level(level),
     blocks(std::make_unique<BlocksController>(level, settings.chunks.padding)),
@@ -43,11 +48,22 @@ void LevelController::update(float delta, bool input, bool pause) {
         }
         blocks->update(delta);
     }
+    level->lighting->update(LIGHTING_BUDGET);
+    invalidateLightsCaches();
+}
+
+void LevelController::invalidateLightsCaches() {
+    auto wfile = level->getWorld()->wfile.get();
+    for (const auto& pos : level->lighting->takeStaleCaches()) {
+        wfile->invalidateFullLights(pos.x, pos.y);
+    }
 }
 
 void LevelController::saveWorld() {
     std::cout << "-- writing world" << std::endl;
     scripting::on_world_save();
+    level->lighting->flush();
+    invalidateLightsCaches();
     level->getWorld()->write(level.get());
 }
 
@@ -19,6 +19,10 @@ class LevelController {
     std::unique_ptr<BlocksController> blocks;
     std::unique_ptr<ChunksController> chunks;
     std::unique_ptr<PlayerController> player;
+
+    /// @brief Invalidate lights caches of not loaded chunks the block
+    /// light removal did not reach (see Lighting::takeStaleCaches)
+    void invalidateLightsCaches();
 public:
     LevelController(EngineSettings& settings, Level* level);
 
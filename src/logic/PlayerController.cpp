@@ -354,7 +354,7 @@ void PlayerController::updateInteraction(){
     glm::vec3 end;
     glm::ivec3 iend;
     glm::ivec3 norm;
-    voxel* vox = chunks->rayCast(
+    const voxel* vox = chunks->rayCast(
         camera->position, 
         camera->front, 
         maxDistance, 
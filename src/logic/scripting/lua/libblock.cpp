@@ -9,6 +9,7 @@
 #include "../../../voxels/voxel.h"
 #include "../../../lighting/Lighting.h"
 #include "../../../content/Content.h"
+#include "../../../maths/voxmaths.h"
 #include "../../../logic/BlocksController.h"
 
 int l_block_name(lua_State* L) {
@@ -59,6 +60,18 @@ int l_set_block(lua_State* L) {
     return 0;
 }
 
+int l_light_batch(lua_State* L) {
+    auto lighting = scripting::level->lighting.get();
+    lighting->beginBatch();
+    lua_pushvalue(L, 1);
+    bool failed = lua_pcall(L, 0, 0, 0);
+    lighting->endBatch();
+    if (failed) {
+        return lua_error(L);
+    }
+    return 0;
+}
+
 static lua::luaint X = 887712735;
 static lua::luaint A1 = 710425958647;
 static lua::luaint B1 = 813638512810;
@@ -101,7 +114,7 @@ int l_get_block(lua_State* L) {
     lua::luaint x = lua_tointeger(L, 1);
     lua::luaint y = lua_tointeger(L, 2);
     lua::luaint z = lua_tointeger(L, 3);
-    voxel* vox = scripting::level->chunks->get(x, y, z);
+    const voxel* vox = scripting::level->chunks->get(x, y, z);
     int id = vox == nullptr ? -1 : vox->id;
     lua_pushinteger(L, id);
     return 1;
@@ -151,7 +164,7 @@ int l_get_block_x(lua_State* L) {
     lua::luaint x = lua_tointeger(L, 1);
     lua::luaint y = lua_tointeger(L, 2);
     lua::luaint z = lua_tointeger(L, 3);
-    voxel* vox = scripting::level->chunks->get(x, y, z);
+    const voxel* vox = scripting::level->chunks->get(x, y, z);
     if (vox == nullptr) {
         return lua::pushivec3(L, 1, 0, 0);
     }
@@ -168,7 +181,7 @@ int l_get_block_y(lua_State* L) {
     lua::luaint x = lua_tointeger(L, 1);
     lua::luaint y = lua_tointeger(L, 2);
     lua::luaint z = lua_tointeger(L, 3);
-    voxel* vox = scripting::level->chunks->get(x, y, z);
+    const voxel* vox = scripting::level->chunks->get(x, y, z);
     if (vox == nullptr) {
         return lua::pushivec3(L, 0, 1, 0);
     }
@@ -185,7 +198,7 @@ int l_get_block_z(lua_State* L) {
     lua::luaint x = lua_tointeger(L, 1);
     lua::luaint y = lua_tointeger(L, 2);
     lua::luaint z = lua_tointeger(L, 3);
-    voxel* vox = scripting::level->chunks->get(x, y, z);
+    const voxel* vox = scripting::level->chunks->get(x, y, z);
     if (vox == nullptr) {
         return lua::pushivec3(L, 0, 0, 1);
     }
@@ -202,7 +215,7 @@ int l_get_block_rotation(lua_State* L) {
     lua::luaint x = lua_tointeger(L, 1);
     lua::luaint y = lua_tointeger(L, 2);
     lua::luaint z = lua_tointeger(L, 3);
-    voxel* vox = scripting::level->chunks->get(x, y, z);
+    const voxel* vox = scripting::level->chunks->get(x, y, z);
     int rotation = vox == nullptr ? 0 : vox->rotation();
     lua_pushinteger(L, rotation);
     return 1;
@@ -213,7 +226,7 @@ int l_set_block_rotation(lua_State* L) {
     lua::luaint y = lua_tointeger(L, 2);
     lua::luaint z = lua_tointeger(L, 3);
     lua::luaint value = lua_tointeger(L, 4);
-    voxel* vox = scripting::level->chunks->get(x, y, z);
+    voxel* vox = scripting::level->chunks->getWriteable(x, y, z);
     if (vox == nullptr) {
         return 0;
     }
@@ -226,7 +239,7 @@ int l_get_block_states(lua_State* L) {
     lua::luaint x = lua_tointeger(L, 1);
     lua::luaint y = lua_tointeger(L, 2);
     lua::luaint z = lua_tointeger(L, 3);
-    voxel* vox = scripting::level->chunks->get(x, y, z);
+    const voxel* vox = scripting::level->chunks->get(x, y, z);
     int states = vox == nullptr ? 0 : vox->states;
     lua_pushinteger(L, states);
     return 1;
@@ -242,7 +255,7 @@ int l_set_block_states(lua_State* L) {
     if (chunk == nullptr) {
         return 0;
     }
-    voxel* vox = scripting::level->chunks->get(x, y, z);
+    voxel* vox = scripting::level->chunks->getWriteable(x, y, z);
     vox->states = states;
     chunk->setModified(true);
     return 0;
@@ -255,7 +268,7 @@ int l_get_block_user_bits(lua_State* L) {
     lua::luaint offset = lua_tointeger(L, 4) + VOXEL_USER_BITS_OFFSET;
     lua::luaint bits = lua_tointeger(L, 5);
 
-    voxel* vox = scripting::level->chunks->get(x, y, z);
+    const voxel* vox = scripting::level->chunks->get(x, y, z);
     if (vox == nullptr) {
         lua_pushinteger(L, 0);
         return 1;
@@ -276,7 +289,7 @@ int l_set_block_user_bits(lua_State* L) {
     uint mask = ((1 << bits) - 1) << offset;
     lua::luaint value = (lua_tointeger(L, 6) << offset) & mask;
     
-    voxel* vox = scripting::level->chunks->get(x, y, z);
+    voxel* vox = scripting::level->chunks->getWriteable(x, y, z);
     if (vox == nullptr) {
         return 0;
     }
@@ -293,13 +306,32 @@ int l_is_replaceable_at(lua_State* L) {
     return 1;
 }
 
+int l_get_surface(lua_State* L) {
+    lua::luaint x = lua_tointeger(L, 1);
+    lua::luaint z = lua_tointeger(L, 2);
+
+    int cx = floordiv(x, CHUNK_W);
+    int cz = floordiv(z, CHUNK_D);
+    Chunk* chunk = scripting::level->chunks->getChunk(cx, cz);
+    if (chunk == nullptr) {
+        lua_pushinteger(L, -1);
+        return 1;
+    }
+    int lx = x - cx * CHUNK_W;
+    int lz = z - cz * CHUNK_D;
+    lua_pushinteger(L, chunk->heightmap.blocks[lz * CHUNK_W + lx]);
+    return 1;
+}
+
 const luaL_Reg blocklib [] = {
     {"index", lua_wrap_errors<l_block_index>},
     {"name", lua_wrap_errors<l_block_name>},
     {"defs_count", lua_wrap_errors<l_blocks_count>},
     {"is_solid_at", lua_wrap_errors<l_is_solid_at>},
     {"is_replaceable_at", lua_wrap_errors<l_is_replaceable_at>},
+    {"get_surface", lua_wrap_errors<l_get_surface>},
     {"set", lua_wrap_errors<l_set_block>},
+    {"light_batch", lua_wrap_errors<l_light_batch>},
     {"get", lua_wrap_errors<l_get_block>},
     {"get_X", lua_wrap_errors<l_get_block_x>},
     {"get_Y", lua_wrap_errors<l_get_block_y>},
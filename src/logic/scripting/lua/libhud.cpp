@@ -43,7 +43,7 @@ static int l_hud_open_block(lua_State* L) {
     lua::luaint z = lua_tointeger(L, 3);
     bool playerInventory = !lua_toboolean(L, 4);
 
-    voxel* vox = scripting::level->chunks->get(x, y, z);
+    const voxel* vox = scripting::level->chunks->get(x, y, z);
     if (vox == nullptr) {
         luaL_error(L, "block does not exists at %d %d %d", x, y, z);
     }
@@ -0,0 +1,316 @@
+#include "PerlinNoise.h"
+
+#include <cmath>
+#include <algorithm>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define PERLIN_NOISE_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define PERLIN_NOISE_SSE2
+#endif
+
+const int PerlinNoise::REFERENCE_PERMUTATION[256] = { 151, 160, 137, 91, 90, 15,
+    131, 13, 201, 95, 96, 53, 194, 233, 7, 225, 140, 36, 103, 30, 69, 142,
+    8, 99, 37, 240, 21, 10, 23, 190, 6, 148, 247, 120, 234, 75, 0, 26, 197,
+    62, 94, 252, 219, 203, 117, 35, 11, 32, 57, 177, 33, 88, 237, 149, 56,
+    87, 174, 20, 125, 136, 171, 168, 68, 175, 74, 165, 71, 134, 139, 48, 27,
+    166, 77, 146, 158, 231, 83, 111, 229, 122, 60, 211, 133, 230, 220, 105,
+    92, 41, 55, 46, 245, 40, 244, 102, 143, 54, 65, 25, 63, 161, 1, 216, 80,
+    73, 209, 76, 132, 187, 208, 89, 18, 169, 200, 196, 135, 130, 116, 188,
+    159, 86, 164, 100, 109, 198, 173, 186, 3, 64, 52, 217, 226, 250, 124, 123,
+    5, 202, 38, 147, 118, 126, 255, 82, 85, 212, 207, 206, 59, 227, 47, 16,
+    58, 17, 182, 189, 28, 42, 223, 183, 170, 213, 119, 248, 152, 2, 44, 154,
+    163, 70, 221, 153, 101, 155, 167, 43, 172, 9, 129, 22, 39, 253, 19, 98,
+    108, 110, 79, 113, 224, 232, 178, 185, 112, 104, 218, 246, 97, 228, 251,
+    34, 242, 193, 238, 210, 144, 12, 191, 179, 162, 241, 81, 51, 145, 235,
+    249, 14, 239, 107, 49, 192, 214, 31, 181, 199, 106, 157, 184, 84, 204,
+    176, 115, 121, 50, 45, 127, 4, 150, 254, 138, 236, 205, 93, 222, 114,
+    67, 29, 24, 72, 243, 141, 128, 195, 78, 66, 215, 61, 156, 180 };
+
+static inline float fade(float t) {
+    return t * t * t * (t * (t * 6 - 15) + 10);
+}
+
+static inline float lerp(float t, float a, float b) {
+    return a + t * (b - a);
+}
+
+static inline float grad(int hash, float x, float y, float z) {
+    int h = hash & 15;
+    float u = h < 8 ? x : y;
+    float v = h < 4 ? y : h == 12 || h == 14 ? x : z;
+    return ((h & 1) == 0 ? u : -u) + ((h & 2) == 0 ? v : -v);
+}
+
+PerlinNoise::PerlinNoise(const int* permutation) {
+    for (int i = 0; i < 256; i++) {
+        p[i] = permutation[i];
+        p[i + 256] = permutation[i];
+    }
+}
+
+float PerlinNoise::noise(float x, float y, float z) const {
+    int X = (int)std::floor(x) & 255;
+    int Y = (int)std::floor(y) & 255;
+    int Z = (int)std::floor(z) & 255;
+
+    x -= std::floor(x);
+    y -= std::floor(y);
+    z -= std::floor(z);
+
+    float u = fade(x);
+    float v = fade(y);
+    float w = fade(z);
+
+    int A = p[X] + Y;
+    int AA = p[A] + Z;
+    int AB = p[A + 1] + Z;
+    int B = p[X + 1] + Y;
+    int BA = p[B] + Z;
+    int BB = p[B + 1] + Z;
+
+    return lerp(w, lerp(v, lerp(u, grad(p[AA], x, y, z),
+        grad(p[BA], x - 1, y, z)),
+        lerp(u, grad(p[AB], x, y - 1, z),
+            grad(p[BB], x - 1, y - 1, z))),
+        lerp(v, lerp(u, grad(p[AA + 1], x, y, z - 1),
+            grad(p[BA + 1], x - 1, y, z - 1)),
+            lerp(u, grad(p[AB + 1], x, y - 1, z - 1),
+                grad(p[BB + 1], x - 1, y - 1, z - 1))));
+}
+
+float PerlinNoise::fbm(float x, float y, float z, int octaves, float persistence) const {
+    float total = 0.0f;
+    float frequency = 1.0f;
+    float amplitude = 1.0f;
+    float maxValue = 0.0f;
+
+    for (int i = 0; i < octaves; i++) {
+        total += noise(x * frequency, y * frequency, z * frequency) * amplitude;
+        maxValue += amplitude;
+        amplitude *= persistence;
+        frequency *= 2.0f;
+    }
+
+    return total / maxValue;
+}
+
+// Batched noise evaluates the same operations as the scalar one, lane-wise:
+// template code is written once over the vector operations set (V)
+
+#ifdef PERLIN_NOISE_SSE2
+struct sse2_ops {
+    using vf = __m128;
+    using vi = __m128i;
+    static constexpr int LANES = 4;
+
+    static inline vf load(const float* src) { return _mm_loadu_ps(src); }
+    static inline void store(float* dst, vf a) { _mm_storeu_ps(dst, a); }
+    static inline vf set(float a) { return _mm_set1_ps(a); }
+    static inline vi seti(int a) { return _mm_set1_epi32(a); }
+    static inline vf add(vf a, vf b) { return _mm_add_ps(a, b); }
+    static inline vf sub(vf a, vf b) { return _mm_sub_ps(a, b); }
+    static inline vf mul(vf a, vf b) { return _mm_mul_ps(a, b); }
+    static inline vf xorf(vf a, vf b) { return _mm_xor_ps(a, b); }
+    static inline vi addi(vi a, vi b) { return _mm_add_epi32(a, b); }
+    static inline vi andi(vi a, vi b) { return _mm_and_si128(a, b); }
+    static inline vi ori(vi a, vi b) { return _mm_or_si128(a, b); }
+    static inline vi eqi(vi a, vi b) { return _mm_cmpeq_epi32(a, b); }
+    static inline vi lti(vi a, vi b) { return _mm_cmplt_epi32(a, b); }
+    static inline vi shli(vi a, int n) { return _mm_slli_epi32(a, n); }
+    static inline vi shri(vi a, int n) { return _mm_srli_epi32(a, n); }
+    static inline vi toint(vf a) { return _mm_cvttps_epi32(a); }
+    static inline vf asfloat(vi a) { return _mm_castsi128_ps(a); }
+
+    /// @return mask ? a : b
+    static inline vf select(vi mask, vf a, vf b) {
+        vf m = _mm_castsi128_ps(mask);
+        return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+    }
+
+    /// @brief SSE2 has no rounding: truncated values greater than 
+    /// the source are decremented (zero sign may differ from std::floor)
+    static inline vf floor(vf a) {
+        vf t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a));
+        return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, a), _mm_set1_ps(1.0f)));
+    }
+
+    static inline vi gather(const int* table, vi index) {
+        alignas(16) int i[LANES];
+        _mm_store_si128(reinterpret_cast<vi*>(i), index);
+        return _mm_setr_epi32(table[i[0]], table[i[1]], table[i[2]], table[i[3]]);
+    }
+};
+using simd_ops = sse2_ops;
+#endif
+
+#ifdef PERLIN_NOISE_AVX2
+struct avx2_ops {
+    using vf = __m256;
+    using vi = __m256i;
+    static constexpr int LANES = 8;
+
+    static inline vf load(const float* src) { return _mm256_loadu_ps(src); }
+    static inline void store(float* dst, vf a) { _mm256_storeu_ps(dst, a); }
+    static inline vf set(float a) { return _mm256_set1_ps(a); }
+    static inline vi seti(int a) { return _mm256_set1_epi32(a); }
+    static inline vf add(vf a, vf b) { return _mm256_add_ps(a, b); }
+    static inline vf sub(vf a, vf b) { return _mm256_sub_ps(a, b); }
+    static inline vf mul(vf a, vf b) { return _mm256_mul_ps(a, b); }
+    static inline vf xorf(vf a, vf b) { return _mm256_xor_ps(a, b); }
+    static inline vi addi(vi a, vi b) { return _mm256_add_epi32(a, b); }
+    static inline vi andi(vi a, vi b) { return _mm256_and_si256(a, b); }
+    static inline vi ori(vi a, vi b) { return _mm256_or_si256(a, b); }
+    static inline vi eqi(vi a, vi b) { return _mm256_cmpeq_epi32(a, b); }
+    static inline vi lti(vi a, vi b) { return _mm256_cmpgt_epi32(b, a); }
+    static inline vi shli(vi a, int n) { return _mm256_slli_epi32(a, n); }
+    static inline vi shri(vi a, int n) { return _mm256_srli_epi32(a, n); }
+    static inline vi toint(vf a) { return _mm256_cvttps_epi32(a); }
+    static inline vf asfloat(vi a) { return _mm256_castsi256_ps(a); }
+
+    /// @return mask ? a : b
+    static inline vf select(vi mask, vf a, vf b) {
+        return _mm256_blendv_ps(b, a, _mm256_castsi256_ps(mask));
+    }
+
+    static inline vf floor(vf a) {
+        return _mm256_floor_ps(a);
+    }
+
+    static inline vi gather(const int* table, vi index) {
+        return _mm256_i32gather_epi32(table, index, 4);
+    }
+};
+using simd_ops = avx2_ops;
+#endif
+
+#if defined(PERLIN_NOISE_SSE2) || defined(PERLIN_NOISE_AVX2)
+template<class V>
+static inline typename V::vf fade(typename V::vf t) {
+    return V::mul(
+        V::mul(V::mul(t, t), t),
+        V::add(V::mul(t, V::sub(V::mul(t, V::set(6)), V::set(15))), V::set(10))
+    );
+}
+
+template<class V>
+static inline typename V::vf lerp(
+    typename V::vf t, typename V::vf a, typename V::vf b
+) {
+    return V::add(a, V::mul(t, V::sub(b, a)));
+}
+
+template<class V>
+static inline typename V::vf grad(
+    typename V::vi hash, typename V::vf x, typename V::vf y, typename V::vf z
+) {
+    auto h = V::andi(hash, V::seti(15));
+    auto u = V::select(V::lti(h, V::seti(8)), x, y);
+    auto v = V::select(
+        V::lti(h, V::seti(4)), 
+        y, 
+        V::select(V::ori(V::eqi(h, V::seti(12)), V::eqi(h, V::seti(14))), x, z)
+    );
+    // negation is the sign bit flip: bit 0 of h negates u, bit 1 negates v
+    auto signU = V::asfloat(V::shli(h, 31));
+    auto signV = V::asfloat(V::shli(V::shri(h, 1), 31));
+    return V::add(V::xorf(u, signU), V::xorf(v, signV));
+}
+
+template<class V>
+static inline typename V::vf noise_lanes(
+    const int* p, typename V::vf x, typename V::vf y, typename V::vf z
+) {
+    auto fx = V::floor(x);
+    auto fy = V::floor(y);
+    auto fz = V::floor(z);
+    auto mask = V::seti(255);
+    auto X = V::andi(V::toint(fx), mask);
+    auto Y = V::andi(V::toint(fy), mask);
+    auto Z = V::andi(V::toint(fz), mask);
+
+    x = V::sub(x, fx);
+    y = V::sub(y, fy);
+    z = V::sub(z, fz);
+
+    auto u = fade<V>(x);
+    auto v = fade<V>(y);
+    auto w = fade<V>(z);
+
+    auto one = V::seti(1);
+    auto A = V::addi(V::gather(p, X), Y);
+    auto AA = V::addi(V::gather(p, A), Z);
+    auto AB = V::addi(V::gather(p, V::addi(A, one)), Z);
+    auto B = V::addi(V::gather(p, V::addi(X, one)), Y);
+    auto BA = V::addi(V::gather(p, B), Z);
+    auto BB = V::addi(V::gather(p, V::addi(B, one)), Z);
+
+    auto x1 = V::sub(x, V::set(1));
+    auto y1 = V::sub(y, V::set(1));
+    auto z1 = V::sub(z, V::set(1));
+
+    return lerp<V>(w, lerp<V>(v, lerp<V>(u, grad<V>(V::gather(p, AA), x, y, z),
+        grad<V>(V::gather(p, BA), x1, y, z)),
+        lerp<V>(u, grad<V>(V::gather(p, AB), x, y1, z),
+            grad<V>(V::gather(p, BB), x1, y1, z))),
+        lerp<V>(v, lerp<V>(u, grad<V>(V::gather(p, V::addi(AA, one)), x, y, z1),
+            grad<V>(V::gather(p, V::addi(BA, one)), x1, y, z1)),
+            lerp<V>(u, grad<V>(V::gather(p, V::addi(AB, one)), x, y1, z1),
+                grad<V>(V::gather(p, V::addi(BB, one)), x1, y1, z1))));
+}
+#endif
+
+void PerlinNoise::noise(
+    const float* x, const float* y, const float* z, float* dst, size_t count
+) const {
+    size_t i = 0;
+#if defined(PERLIN_NOISE_SSE2) || defined(PERLIN_NOISE_AVX2)
+    using V = simd_ops;
+    for (; i + V::LANES <= count; i += V::LANES) {
+        V::store(dst + i, noise_lanes<V>(
+            p, V::load(x + i), V::load(y + i), V::load(z + i)
+        ));
+    }
+#endif
+    for (; i < count; i++) {
+        dst[i] = noise(x[i], y[i], z[i]);
+    }
+}
+
+void PerlinNoise::fbm(
+    const float* x, const float* y, const float* z, float* dst, size_t count,
+    int octaves, float persistence
+) const {
+    float fx[BATCH_SIZE];
+    float fy[BATCH_SIZE];
+    float fz[BATCH_SIZE];
+    float values[BATCH_SIZE];
+    for (size_t start = 0; start < count; start += BATCH_SIZE) {
+        size_t n = std::min(BATCH_SIZE, count - start);
+        float* total = dst + start;
+        std::fill_n(total, n, 0.0f);
+        float frequency = 1.0f;
+        float amplitude = 1.0f;
+        float maxValue = 0.0f;
+
+        for (int octave = 0; octave < octaves; octave++) {
+            for (size_t i = 0; i < n; i++) {
+                fx[i] = x[start + i] * frequency;
+                fy[i] = y[start + i] * frequency;
+                fz[i] = z[start + i] * frequency;
+            }
+            noise(fx, fy, fz, values, n);
+            for (size_t i = 0; i < n; i++) {
+                total[i] += values[i] * amplitude;
+            }
+            maxValue += amplitude;
+            amplitude *= persistence;
+            frequency *= 2.0f;
+        }
+        for (size_t i = 0; i < n; i++) {
+            total[i] /= maxValue;
+        }
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef MATHS_PERLIN_NOISE_H_
+#define MATHS_PERLIN_NOISE_H_
+
+#include <stddef.h>
+
+/// @brief Improved Perlin noise over a fixed permutation table.
+/// The table is filled on construction and never changed after,
+/// so one instance may be used by multiple threads at once
+class PerlinNoise {
+    /// @brief Permutation repeated twice, so indices do not wrap
+    int p[512];
+public:
+    /// @brief Ken Perlin's reference permutation of 0..255
+    static const int REFERENCE_PERMUTATION[256];
+
+    /// @param permutation 256 table values
+    PerlinNoise(const int* permutation=REFERENCE_PERMUTATION);
+
+    float noise(float x, float y, float z) const;
+
+    /// @brief Fractal sum of noise octaves, each one of doubled frequency
+    /// @return sum normalized by the total amplitude
+    float fbm(float x, float y, float z, int octaves, float persistence) const;
+
+    /// @brief Max points count the batch helpers (sample, sampleFbm)
+    /// evaluate at once
+    static constexpr size_t BATCH_SIZE = 64;
+
+    /// @brief Noise of count points at once, vectorized with SSE2 or AVX2 
+    /// (if enabled for the build). Same as the point-wise noise up to 
+    /// the zero sign with SSE2 (or ulps if the scalar code is contracted
+    /// to FMA by the compiler)
+    void noise(
+        const float* x, const float* y, const float* z, float* dst, 
+        size_t count
+    ) const;
+
+    /// @brief Fractal noise of count points at once (see noise and fbm)
+    void fbm(
+        const float* x, const float* y, const float* z, float* dst, 
+        size_t count, int octaves, float persistence
+    ) const;
+
+    /// @brief Noise of count points with coordinates given by 
+    /// coords(index, x, y, z) taking point index and float references
+    template<class F>
+    void sample(float* dst, size_t count, const F& coords) const {
+        float x[BATCH_SIZE];
+        float y[BATCH_SIZE];
+        float z[BATCH_SIZE];
+        for (size_t start = 0; start < count; start += BATCH_SIZE) {
+            size_t n = count - start < BATCH_SIZE ? count - start : BATCH_SIZE;
+            for (size_t i = 0; i < n; i++) {
+                coords(start + i, x[i], y[i], z[i]);
+            }
+            noise(x, y, z, dst + start, n);
+        }
+    }
+
+    /// @brief Fractal noise of count points with coordinates given by
+    /// coords(index, x, y, z) (see sample)
+    template<class F>
+    void sampleFbm(
+        float* dst, size_t count, int octaves, float persistence, 
+        const F& coords
+    ) const {
+        float x[BATCH_SIZE];
+        float y[BATCH_SIZE];
+        float z[BATCH_SIZE];
+        for (size_t start = 0; start < count; start += BATCH_SIZE) {
+            size_t n = count - start < BATCH_SIZE ? count - start : BATCH_SIZE;
+            for (size_t i = 0; i < n; i++) {
+                coords(start + i, x[i], y[i], z[i]);
+            }
+            fbm(x, y, z, dst + start, n, octaves, persistence);
+        }
+    }
+};
+
+#endif // MATHS_PERLIN_NOISE_H_
@@ -4,6 +4,7 @@
 #include "../maths/aabb.h"
 #include "../voxels/Block.h"
 #include "../voxels/Chunks.h"
+#include "../voxels/ChunkCursor.h"
 #include "../voxels/voxel.h"
 
 const double E = 0.03;
@@ -46,11 +47,12 @@ void PhysicsSolver::step(
 		pos += vel * dt;
 
 		if (shifting && hitbox->grounded){
+			ChunkCursor cursor(*chunks);
 			float y = (pos.y-half.y-E);
 			hitbox->grounded = false;
 			for (float x = (px-half.x+E); x <= (px+half.x-E); x+=s){
 				for (float z = (pos.z-half.z+E); z <= (pos.z+half.z-E); z+=s){
-					if (chunks->isObstacleAt(x,y,z)){
+					if (chunks->isObstacleAt(cursor, x,y,z)){
 						hitbox->grounded = true;
 						break;
 					}
@@ -62,7 +64,7 @@ void PhysicsSolver::step(
 			hitbox->grounded = false;
 			for (float x = (pos.x-half.x+E); x <= (pos.x+half.x-E); x+=s){
 				for (float z = (pz-half.z+E); z <= (pz+half.z-E); z+=s){
-					if (chunks->isObstacleAt(x,y,z)){
+					if (chunks->isObstacleAt(cursor, x,y,z)){
 						hitbox->grounded = true;
 						break;
 					}
@@ -86,11 +88,12 @@ void PhysicsSolver::colisionCalc(
 {
 	// step size (smaller - more accurate, but slower)
 	float s = 2.0f/BLOCK_AABB_GRID;
+	ChunkCursor cursor(*chunks);
 
     if (stepHeight > 0.0f) {
         for (float x = (pos.x-half.x+E); x <= (pos.x+half.x-E); x+=s){
             for (float z = (pos.z-half.z+E); z <= (pos.z+half.z-E); z+=s){
-                if (chunks->isObstacleAt(x, pos.y+half.y+stepHeight, z)) {
+                if (chunks->isObstacleAt(cursor, x, pos.y+half.y+stepHeight, z)) {
                     stepHeight = 0.0f;
                     break;
                 }
@@ -104,7 +107,7 @@ void PhysicsSolver::colisionCalc(
 		for (float y = (pos.y-half.y+E+stepHeight); y <= (pos.y+half.y-E); y+=s){
 			for (float z = (pos.z-half.z+E); z <= (pos.z+half.z-E); z+=s){
 				float x = (pos.x-half.x-E);
-				if ((aabb = chunks->isObstacleAt(x,y,z))){
+				if ((aabb = chunks->isObstacleAt(cursor, x,y,z))){
 					vel.x *= 0.0f;
 					float newx = floor(x) + aabb->max().x + half.x + E;
 					if (glm::abs(newx-pos.x) <= MAX_FIX) {
@@ -119,7 +122,7 @@ void PhysicsSolver::colisionCalc(
 		for (float y = (pos.y-half.y+E+stepHeight); y <= (pos.y+half.y-E); y+=s){
 			for (float z = (pos.z-half.z+E); z <= (pos.z+half.z-E); z+=s){
 				float x = (pos.x+half.x+E);
-				if ((aabb = chunks->isObstacleAt(x,y,z))){
+				if ((aabb = chunks->isObstacleAt(cursor, x,y,z))){
 					vel.x *= 0.0f;
 					float newx = floor(x) - half.x + aabb->min().x - E;
 					if (glm::abs(newx-pos.x) <= MAX_FIX) {
@@ -135,7 +138,7 @@ void PhysicsSolver::colisionCalc(
 		for (float y = (pos.y-half.y+E+stepHeight); y <= (pos.y+half.y-E); y+=s){
 			for (float x = (pos.x-half.x+E); x <= (pos.x+half.x-E); x+=s){
 				float z = (pos.z-half.z-E);
-				if ((aabb = chunks->isObstacleAt(x,y,z))){
+				if ((aabb = chunks->isObstacleAt(cursor, x,y,z))){
 					vel.z *= 0.0f;
 					float newz = floor(z) + aabb->max().z + half.z + E;
 					if (glm::abs(newz-pos.z) <= MAX_FIX) { 
@@ -151,7 +154,7 @@ void PhysicsSolver::colisionCalc(
 		for (float y = (pos.y-half.y+E+stepHeight); y <= (pos.y+half.y-E); y+=s){
 			for (float x = (pos.x-half.x+E); x <= (pos.x+half.x-E); x+=s){
 				float z = (pos.z+half.z+E);
-				if ((aabb = chunks->isObstacleAt(x,y,z))){
+				if ((aabb = chunks->isObstacleAt(cursor, x,y,z))){
 					vel.z *= 0.0f;
 					float newz = floor(z) - half.z + aabb->min().z - E;
 					if (glm::abs(newz-pos.z) <= MAX_FIX) {
@@ -167,7 +170,7 @@ void PhysicsSolver::colisionCalc(
 		for (float x = (pos.x-half.x+E); x <= (pos.x+half.x-E); x+=s){
 			for (float z = (pos.z-half.z+E); z <= (pos.z+half.z-E); z+=s){
 				float y = (pos.y-half.y-E);
-				if ((aabb = chunks->isObstacleAt(x,y,z))){
+				if ((aabb = chunks->isObstacleAt(cursor, x,y,z))){
 					vel.y *= 0.0f;
 					float newy = floor(y) + aabb->max().y + half.y;
 					if (glm::abs(newy-pos.y) <= MAX_FIX) {
@@ -183,7 +186,7 @@ void PhysicsSolver::colisionCalc(
 		for (float x = (pos.x-half.x+E); x <= (pos.x+half.x-E); x+=s){
 			for (float z = (pos.z-half.z+E); z <= (pos.z+half.z-E); z+=s){
 				float y = (pos.y-half.y+E);
-				if ((aabb = chunks->isObstacleAt(x,y,z))){
+				if ((aabb = chunks->isObstacleAt(cursor, x,y,z))){
 					vel.y *= 0.0f;
 					float newy = floor(y) + aabb->max().y + half.y;
 					if (glm::abs(newy-pos.y) <= MAX_FIX+stepHeight) {
@@ -198,7 +201,7 @@ void PhysicsSolver::colisionCalc(
 		for (float x = (pos.x-half.x+E); x <= (pos.x+half.x-E); x+=s){
 			for (float z = (pos.z-half.z+E); z <= (pos.z+half.z-E); z+=s){
 				float y = (pos.y+half.y+E);
-				if ((aabb = chunks->isObstacleAt(x,y,z))){
+				if ((aabb = chunks->isObstacleAt(cursor, x,y,z))){
 					vel.y *= 0.0f;
 					float newy = floor(y) - half.y + aabb->min().y - E;
 					if (glm::abs(newy-pos.y) <= MAX_FIX) {
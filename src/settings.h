@@ -71,6 +71,19 @@ struct DebugSettings {
     bool generatorTestMode = false;
     bool showChunkBorders = false;
     bool doWriteLights = true;
+    /// @brief Write all light channels to the lights cache (not only 
+    /// sky light), so chunks loaded are not relit
+    bool doWriteFullLights = true;
+    /// @brief Read region files via memory mapping where supported
+    bool mmapRegions = true;
+    /// @brief Max number of region files open at the same time
+    /// (each region has up to 3 files: voxels, lights, inventories)
+    uint regionFilesLimit = 48;
+    /// @brief Read chunks data ahead of the player movement direction
+    bool regionsReadAhead = true;
+    /// @brief Memory limit for saved compressed chunks kept in 
+    /// regions cache (MiB)
+    uint regionsCacheLimit = 256;
 };
 
 struct UiSettings {
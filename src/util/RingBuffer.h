@@ -0,0 +1,72 @@
+#ifndef UTIL_RING_BUFFER_H_
+#define UTIL_RING_BUFFER_H_
+
+#include <memory>
+#include <algorithm>
+
+namespace util {
+    /// @brief FIFO queue stored in a power of two sized circular array.
+    /// Grows twice when full and never shrinks, so steady use does
+    /// not allocate
+    /// @tparam T element type (trivially copyable)
+    template<class T>
+    class RingBuffer {
+        std::unique_ptr<T[]> data;
+        size_t mask;
+        size_t head = 0;
+        size_t count = 0;
+
+        void grow() {
+            size_t capacity = mask + 1;
+            auto expanded = std::make_unique<T[]>(capacity * 2);
+            // unwrap elements to the beginning of the new array
+            size_t tail = std::min(count, capacity - head);
+            std::copy_n(data.get() + head, tail, expanded.get());
+            std::copy_n(data.get(), count - tail, expanded.get() + tail);
+            data = std::move(expanded);
+            mask = capacity * 2 - 1;
+            head = 0;
+        }
+    public:
+        /// @param capacity initial capacity (rounded up to a power of two)
+        RingBuffer(size_t capacity) {
+            size_t size = 1;
+            while (size < capacity) {
+                size <<= 1;
+            }
+            data = std::make_unique<T[]>(size);
+            mask = size - 1;
+        }
+
+        inline void push(const T& value) {
+            if (count == mask + 1) {
+                grow();
+            }
+            data[(head + count) & mask] = value;
+            count++;
+        }
+
+        /// @brief Remove and return the first element (must not be empty)
+        inline T pop() {
+            T value = data[head];
+            head = (head + 1) & mask;
+            count--;
+            return value;
+        }
+
+        inline bool empty() const {
+            return count == 0;
+        }
+
+        inline size_t size() const {
+            return count;
+        }
+
+        inline void clear() {
+            head = 0;
+            count = 0;
+        }
+    };
+}
+
+#endif // UTIL_RING_BUFFER_H_
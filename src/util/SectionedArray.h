@@ -0,0 +1,193 @@
+#ifndef UTIL_SECTIONED_ARRAY_H_
+#define UTIL_SECTIONED_ARRAY_H_
+
+#include <atomic>
+#include <algorithm>
+
+#include "../typedefs.h"
+
+namespace util {
+    /// @brief Fixed size array split into sections. Section filled with
+    /// a single value is stored as that value and is allocated on the
+    /// first write of a different value.
+    /// Allocated section is published with release ordering and read with
+    /// acquire, so readers on other threads see it filled with the uniform
+    /// value. Elements access itself is not synchronized, and methods 
+    /// deallocating sections are not safe while other threads read.
+    /// @tparam T element type (trivially copyable, equality comparable)
+    /// @tparam sectionSize number of elements in a section
+    /// @tparam sectionsCount number of sections
+    template<class T, uint sectionSize, uint sectionsCount>
+    class SectionedArray {
+        /// @brief Owned sections data, nullptr if section is not allocated
+        std::atomic<T*> sections[sectionsCount];
+        /// @brief Value of all elements of not allocated section
+        T uniform[sectionsCount];
+
+        inline T* load(uint section) const {
+            return sections[section].load(std::memory_order_acquire);
+        }
+
+        T* expand(uint section) {
+            T* data = load(section);
+            if (data == nullptr) {
+                T* allocated = new T[sectionSize];
+                std::fill_n(allocated, sectionSize, uniform[section]);
+                // section may be allocated by another writer meanwhile
+                if (sections[section].compare_exchange_strong(
+                    data, allocated, 
+                    std::memory_order_release, std::memory_order_acquire
+                )) {
+                    data = allocated;
+                } else {
+                    delete[] allocated;
+                }
+            }
+            return data;
+        }
+    public:
+        static constexpr size_t SIZE = size_t(sectionSize) * sectionsCount;
+
+        SectionedArray(T value = T {}) {
+            for (auto& section : sections) {
+                section.store(nullptr, std::memory_order_relaxed);
+            }
+            fill(value);
+        }
+
+        SectionedArray(const SectionedArray& other) : SectionedArray() {
+            *this = other;
+        }
+
+        ~SectionedArray() {
+            for (auto& section : sections) {
+                delete[] section.load(std::memory_order_relaxed);
+            }
+        }
+
+        SectionedArray& operator=(const SectionedArray& other) {
+            for (uint i = 0; i < sectionsCount; i++) {
+                uniform[i] = other.uniform[i];
+                if (const T* data = other.load(i)) {
+                    std::copy_n(data, sectionSize, expand(i));
+                } else {
+                    fillSection(i, other.uniform[i]);
+                }
+            }
+            return *this;
+        }
+
+        inline const T& operator[](size_t index) const {
+            uint section = index / sectionSize;
+            const T* data = load(section);
+            if (data) {
+                return data[index % sectionSize];
+            }
+            return uniform[section];
+        }
+
+        /// @brief Get element reference for writing.
+        /// Section containing the element becomes allocated
+        inline T& getWriteable(size_t index) {
+            return expand(index / sectionSize)[index % sectionSize];
+        }
+
+        /// @brief Set element value. Section stays not allocated if
+        /// the value is the same as section uniform value
+        inline void set(size_t index, T value) {
+            uint section = index / sectionSize;
+            T* data = load(section);
+            if (data) {
+                data[index % sectionSize] = value;
+            } else if (!(uniform[section] == value)) {
+                expand(section)[index % sectionSize] = value;
+            }
+        }
+
+        /// @brief Copy elements from the source array deallocating
+        /// uniform sections. Not safe if the array is read by other threads
+        /// @param src source array of SIZE elements
+        void set(const T* src) {
+            for (uint i = 0; i < sectionsCount; i++) {
+                const T* begin = src + size_t(i) * sectionSize;
+                const T* end = begin + sectionSize;
+                const T& first = *begin;
+                bool isUniform = std::all_of(begin, end, [&first](const T& value) {
+                    return value == first;
+                });
+                if (isUniform) {
+                    fillSection(i, first);
+                } else {
+                    std::copy(begin, end, expand(i));
+                }
+            }
+        }
+
+        /// @brief Copy all elements to the destination array
+        /// @param dst destination array of SIZE elements
+        void get(T* dst) const {
+            for (uint i = 0; i < sectionsCount; i++) {
+                T* begin = dst + size_t(i) * sectionSize;
+                if (const T* data = load(i)) {
+                    std::copy_n(data, sectionSize, begin);
+                } else {
+                    std::fill_n(begin, sectionSize, uniform[i]);
+                }
+            }
+        }
+
+        /// @brief Fill all elements deallocating all sections.
+        /// Not safe if the array is read by other threads
+        void fill(T value) {
+            for (uint i = 0; i < sectionsCount; i++) {
+                fillSection(i, value);
+            }
+        }
+
+        /// @brief Fill section elements deallocating the section.
+        /// Not safe if the array is read by other threads
+        void fillSection(uint section, T value) {
+            delete[] sections[section].exchange(nullptr, std::memory_order_relaxed);
+            uniform[section] = value;
+        }
+
+        /// @brief Deallocate sections filled with a single value.
+        /// Not safe if the array is read by other threads
+        void compact() {
+            for (uint i = 0; i < sectionsCount; i++) {
+                const T* data = load(i);
+                if (data && std::all_of(data, data + sectionSize,
+                    [data](const T& value) {
+                        return value == data[0];
+                    })) {
+                    fillSection(i, data[0]);
+                }
+            }
+        }
+
+        /// @return true if section is not allocated
+        inline bool isUniform(uint section) const {
+            return load(section) == nullptr;
+        }
+
+        /// @return value of all elements of not allocated section
+        inline const T& getUniform(uint section) const {
+            return uniform[section];
+        }
+
+        /// @return section data or nullptr if section is not allocated
+        inline const T* getSection(uint section) const {
+            return load(section);
+        }
+
+        uint countAllocated() const {
+            uint count = 0;
+            for (uint i = 0; i < sectionsCount; i++) {
+                count += load(i) != nullptr;
+            }
+            return count;
+        }
+    };
+}
+
+#endif // UTIL_SECTIONED_ARRAY_H_
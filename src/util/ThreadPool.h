@@ -0,0 +1,173 @@
+#ifndef UTIL_THREAD_POOL_H_
+#define UTIL_THREAD_POOL_H_
+
+#include <deque>
+#include <queue>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+#include "../typedefs.h"
+
+namespace util {
+    /// @brief Fixed-size pool of worker threads turning jobs of type J
+    /// into results of type R. Results are collected on the owner thread
+    /// with pollResult (after waitAll if jobs are processed fork-join).
+    /// @tparam J job type (default-constructible, movable)
+    /// @tparam R result type (default-constructible, movable)
+    template<class J, class R>
+    class ThreadPool {
+        std::string name;
+        std::function<R(J&)> worker;
+        std::vector<std::thread> threads;
+
+        std::deque<J> jobs;
+        /// @brief Jobs taken by workers only when there are no regular ones
+        std::deque<J> lowPriorityJobs;
+        std::condition_variable jobsMutexCondition;
+        /// @brief Notified when a worker finishes a job
+        std::condition_variable jobsDoneCondition;
+        std::mutex jobsMutex;
+
+        std::queue<R> results;
+        std::exception_ptr failure = nullptr;
+        std::mutex resultsMutex;
+
+        /// @brief Count of jobs taken by workers and not finished yet
+        uint busyWorkers = 0;
+        bool working = true;
+
+        void threadLoop() {
+            while (true) {
+                J job;
+                {
+                    std::unique_lock<std::mutex> lock(jobsMutex);
+                    jobsMutexCondition.wait(lock, [this] {
+                        return !jobs.empty() || !lowPriorityJobs.empty() || 
+                               !working;
+                    });
+                    if (!working) {
+                        break;
+                    }
+                    auto& queue = jobs.empty() ? lowPriorityJobs : jobs;
+                    job = std::move(queue.front());
+                    queue.pop_front();
+                    busyWorkers++;
+                }
+                try {
+                    R result = worker(job);
+                    std::lock_guard<std::mutex> lock(resultsMutex);
+                    results.push(std::move(result));
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(resultsMutex);
+                    if (failure == nullptr) {
+                        failure = std::current_exception();
+                    }
+                }
+                {
+                    std::lock_guard<std::mutex> lock(jobsMutex);
+                    busyWorkers--;
+                }
+                jobsDoneCondition.notify_all();
+            }
+        }
+    public:
+        /// @param name pool name (to tell pools apart when debugging)
+        /// @param worker job handler called from the worker threads
+        /// @param threadsCount number of worker threads to start
+        ThreadPool(
+            std::string name,
+            std::function<R(J&)> worker,
+            uint threadsCount
+        ) : name(std::move(name)), worker(std::move(worker)) {
+            if (threadsCount == 0) {
+                threadsCount = 1;
+            }
+            for (uint i = 0; i < threadsCount; i++) {
+                threads.emplace_back(&ThreadPool::threadLoop, this);
+            }
+        }
+
+        ~ThreadPool() {
+            {
+                std::lock_guard<std::mutex> lock(jobsMutex);
+                working = false;
+            }
+            jobsMutexCondition.notify_all();
+            for (auto& thread : threads) {
+                thread.join();
+            }
+        }
+
+        /// @param lowPriority job is taken only when all regular jobs
+        /// are taken
+        void enqueueJob(J job, bool lowPriority=false) {
+            {
+                std::lock_guard<std::mutex> lock(jobsMutex);
+                (lowPriority ? lowPriorityJobs : jobs).push_back(std::move(job));
+            }
+            jobsMutexCondition.notify_one();
+        }
+
+        /// @brief Remove not started jobs matching the predicate.
+        /// Jobs being processed at the moment are not affected.
+        /// @return number of removed jobs
+        template<class Predicate>
+        size_t removeJobs(Predicate predicate) {
+            std::lock_guard<std::mutex> lock(jobsMutex);
+            size_t size = jobs.size() + lowPriorityJobs.size();
+            for (auto queue : {&jobs, &lowPriorityJobs}) {
+                queue->erase(
+                    std::remove_if(queue->begin(), queue->end(), predicate),
+                    queue->end()
+                );
+            }
+            return size - jobs.size() - lowPriorityJobs.size();
+        }
+
+        /// @brief Take one finished result if available.
+        /// Rethrows exception thrown by a worker if any.
+        /// @param dst result destination
+        /// @return true if result was taken
+        bool pollResult(R& dst) {
+            std::lock_guard<std::mutex> lock(resultsMutex);
+            if (failure) {
+                auto exception = failure;
+                failure = nullptr;
+                std::rethrow_exception(exception);
+            }
+            if (results.empty()) {
+                return false;
+            }
+            dst = std::move(results.front());
+            results.pop();
+            return true;
+        }
+
+        /// @brief Block until all enqueued jobs are finished
+        void waitAll() {
+            std::unique_lock<std::mutex> lock(jobsMutex);
+            jobsDoneCondition.wait(lock, [this] {
+                return jobs.empty() && lowPriorityJobs.empty() && 
+                       busyWorkers == 0;
+            });
+        }
+
+        /// @return number of queued and currently processed jobs
+        size_t countPendingJobs() {
+            std::lock_guard<std::mutex> lock(jobsMutex);
+            return jobs.size() + lowPriorityJobs.size() + busyWorkers;
+        }
+
+        uint getWorkersCount() const {
+            return threads.size();
+        }
+    };
+}
+
+#endif // UTIL_THREAD_POOL_H_
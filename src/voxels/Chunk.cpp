@@ -2,17 +2,32 @@
 
 #include "voxel.h"
 
+#include <vector>
+#include <algorithm>
+
 #include "../items/Inventory.h"
+#include "../content/Content.h"
 #include "../content/ContentLUT.h"
 #include "../lighting/Lightmap.h"
 
 Chunk::Chunk(int xpos, int zpos) : x(xpos), z(zpos){
 	bottom = 0;
 	top = CHUNK_H;
-	for (uint i = 0; i < CHUNK_VOL; i++) {
-		voxels[i].id = 2;
-		voxels[i].states = 0;
-	}
+	voxels.fill(voxel {2, 0});
+}
+
+void Chunk::reset(int xpos, int zpos, bool fill) {
+    x = xpos;
+    z = zpos;
+    bottom = 0;
+    top = CHUNK_H;
+    flags = 0;
+    inventories.clear();
+    lightmap.highestPoint = 0;
+    if (fill) {
+        voxels.fill(voxel {2, 0});
+        lightmap.map.fill(0);
+    }
 }
 
 bool Chunk::isEmpty(){
@@ -28,19 +43,85 @@ bool Chunk::isEmpty(){
 	return true;
 }
 
-void Chunk::updateHeights() {
-	for (uint i = 0; i < CHUNK_VOL; i++) {
-		if (voxels[i].id != 0) {
-			bottom = i / (CHUNK_D * CHUNK_W);
-			break;
-		}
-	}
-	for (int i = CHUNK_VOL - 1; i >= 0; i--) {
-		if (voxels[i].id != 0) {
-			top = i / (CHUNK_D * CHUNK_W) + 1;
-			break;
-		}
+void Chunk::updateHeights(const ContentIndices* indices) {
+	for (uint s = 0; s < CHUNK_SECTIONS; s++) {
+        // sections of air only are skipped without checking voxels
+        if (voxels.isUniform(s) && voxels.getUniform(s).id == 0) {
+            continue;
+        }
+        bool found = false;
+        for (uint i = s * CHUNK_SECTION_VOL; i < (s+1) * CHUNK_SECTION_VOL; i++) {
+            if (voxels[i].id != 0) {
+                bottom = i / (CHUNK_D * CHUNK_W);
+                found = true;
+                break;
+            }
+        }
+        if (found) {
+            break;
+        }
 	}
+    const ubyte* skyLightPassing = indices->getBlockProps().skyLightPassing.data();
+    for (uint z = 0; z < CHUNK_D; z++) {
+        for (uint x = 0; x < CHUNK_W; x++) {
+            scanColumn(x, z, skyLightPassing);
+        }
+    }
+    updateTop();
+}
+
+void Chunk::updateColumn(uint x, uint z, const ContentIndices* indices) {
+    uint column = z * CHUNK_W + x;
+    int prevBlock = heightmap.blocks[column];
+    scanColumn(x, z, indices->getBlockProps().skyLightPassing.data());
+    int block = heightmap.blocks[column];
+    if (block + 1 > top) {
+        top = block + 1;
+    } else if (block < prevBlock && prevBlock + 1 == top) {
+        // the column was the highest one, so others are checked
+        updateTop();
+    }
+}
+
+void Chunk::scanColumn(uint x, uint z, const ubyte* skyLightPassing) {
+    int block = -1;
+    int y = CHUNK_H-1;
+    int skyLight = -1;
+    while (y >= 0) {
+        uint section = y / CHUNK_SECTION_H;
+        // column part in uniform section is checked at once
+        if (voxels.isUniform(section)) {
+            blockid_t id = voxels.getUniform(section).id;
+            if (block == -1 && id != 0) {
+                block = y;
+            }
+            if (!skyLightPassing[id]) {
+                skyLight = y;
+                break;
+            }
+            y = section * CHUNK_SECTION_H - 1;
+            continue;
+        }
+        blockid_t id = voxels[vox_index(x, y, z)].id;
+        if (block == -1 && id != 0) {
+            block = y;
+        }
+        if (!skyLightPassing[id]) {
+            skyLight = y;
+            break;
+        }
+        y--;
+    }
+    heightmap.blocks[z * CHUNK_W + x] = block;
+    heightmap.skyLight[z * CHUNK_W + x] = skyLight;
+}
+
+void Chunk::updateTop() {
+    int highest = -1;
+    for (uint i = 0; i < CHUNK_W * CHUNK_D; i++) {
+        highest = std::max(highest, int(heightmap.blocks[i]));
+    }
+    top = highest + 1;
 }
 
 void Chunk::addBlockInventory(std::shared_ptr<Inventory> inventory, 
@@ -71,39 +152,222 @@ std::shared_ptr<Inventory> Chunk::getBlockInventory(uint x, uint y, uint z) cons
 
 std::unique_ptr<Chunk> Chunk::clone() const {
 	auto other = std::make_unique<Chunk>(x,z);
-	for (uint i = 0; i < CHUNK_VOL; i++) {
-		other->voxels[i] = voxels[i];
-    }
+	other->voxels = voxels;
 	other->lightmap.set(&lightmap);
+	other->heightmap = heightmap;
 	return other;
 }
 
 /** 
-  Current chunk format:
+  Encoded chunk voxels format:
     - byte-order: big-endian
+    - first byte is format: CHUNK_FORMAT_PLAIN or CHUNK_FORMAT_PALETTE
+
+  Plain format:
     - [don't panic!] first and second bytes are separated for RLE efficiency
 
     ```cpp
+    uint8_t format; // CHUNK_FORMAT_PLAIN
     uint8_t voxel_id_first_byte[CHUNK_VOL];
     uint8_t voxel_id_second_byte[CHUNK_VOL];
     uint8_t voxel_states_first_byte[CHUNK_VOL];
     uint8_t voxel_states_second_byte[CHUNK_VOL];
     ```
 
-    Total size: (CHUNK_VOL * 4) bytes
+    Total size: (1 + CHUNK_VOL * 4) bytes
+
+  Palette format:
+    - used if chunk has up to CHUNK_PALETTE_MAX_SIZE different voxels
+    - distinct voxels listed in the palette, voxels are stored 
+      as palette indices of 0, 1, 2, 4 or 8 bits 
+      (packed from the most significant bit)
+
+    ```cpp
+    uint8_t format; // CHUNK_FORMAT_PALETTE
+    uint16_t palette_size;
+    struct {
+        uint16_t id;
+        uint16_t states;
+    } palette[palette_size];
+    uint8_t bits;
+    uint8_t indices[CHUNK_VOL * bits / 8];
+    ```
 */
-ubyte* Chunk::encode() const {
-	ubyte* buffer = new ubyte[CHUNK_DATA_LEN];
+static uint palette_index_bits(size_t paletteSize) {
+    uint bits = 0;
+    while ((size_t(1) << bits) < paletteSize) {
+        bits = bits ? bits * 2 : 1;
+    }
+    return bits;
+}
+
+static size_t palette_encoded_size(size_t paletteSize, uint bits) {
+    return 3 + paletteSize * 4 + 1 + CHUNK_VOL / 8 * bits;
+}
+
+/// @brief Read palette format header checking data length
+/// @param paletteSize (out argument) number of palette entries
+/// @param bits (out argument) palette index bits
+/// @return false if header is invalid or data length does not match it
+static bool read_palette_header(
+    const ubyte* data, size_t size, uint& paletteSize, uint& bits
+) {
+    if (size < 3) {
+        return false;
+    }
+    paletteSize = (uint(data[1]) << 8) | data[2];
+    if (paletteSize == 0 || paletteSize > CHUNK_PALETTE_MAX_SIZE) {
+        return false;
+    }
+    size_t offset = 3 + paletteSize * 4;
+    if (size <= offset) {
+        return false;
+    }
+    bits = data[offset];
+    return bits == palette_index_bits(paletteSize) && 
+           size == palette_encoded_size(paletteSize, bits);
+}
+
+template<uint bits>
+static void pack_indices(const ubyte* src, ubyte* dst) {
+    constexpr uint perByte = 8 / bits;
+    for (uint i = 0; i < CHUNK_VOL / perByte; i++) {
+        uint byte = 0;
+        for (uint j = 0; j < perByte; j++) {
+            byte = (byte << bits) | *(src++);
+        }
+        dst[i] = byte;
+    }
+}
+
+/// @return the greatest palette index unpacked
+template<uint bits>
+static uint unpack_indices(const ubyte* src, const voxel* palette, voxel* dst) {
+    constexpr uint perByte = 8 / bits;
+    constexpr uint mask = (1 << bits) - 1;
+    uint maxIndex = 0;
+    for (uint i = 0; i < CHUNK_VOL / perByte; i++) {
+        uint byte = src[i];
+        for (uint j = 0; j < perByte; j++) {
+            uint index = (byte >> (8 - bits * (j + 1))) & mask;
+            maxIndex = std::max(maxIndex, index);
+            *(dst++) = palette[index];
+        }
+    }
+    return maxIndex;
+}
+
+ubyte* Chunk::encodePlain(const voxel* voxels) {
+    ubyte* buffer = new ubyte[CHUNK_ENCODED_MAX_LEN];
+    buffer[0] = CHUNK_FORMAT_PLAIN;
+    ubyte* dst = buffer + 1;
 	for (uint i = 0; i < CHUNK_VOL; i++) {
-		buffer[i] = voxels[i].id >> 8;
-        buffer[CHUNK_VOL+i] = voxels[i].id & 0xFF;
-		buffer[CHUNK_VOL*2 + i] = voxels[i].states >> 8;
-        buffer[CHUNK_VOL*3 + i] = voxels[i].states & 0xFF;
+		dst[i] = voxels[i].id >> 8;
+        dst[CHUNK_VOL+i] = voxels[i].id & 0xFF;
+		dst[CHUNK_VOL*2 + i] = voxels[i].states >> 8;
+        dst[CHUNK_VOL*3 + i] = voxels[i].states & 0xFF;
 	}
-	return buffer;
+    return buffer;
+}
+
+ubyte* Chunk::encode(const voxel* voxels, size_t& size) {
+    std::unordered_map<uint32_t, uint> indices;
+    std::vector<voxel> palette;
+    auto paletteIndices = std::make_unique<ubyte[]>(CHUNK_VOL);
+
+    uint32_t prevKey = 0;
+    uint prevIndex = 0;
+	for (uint i = 0; i < CHUNK_VOL; i++) {
+        uint32_t key = (uint32_t(voxels[i].id) << 16) | voxels[i].states;
+        if (i == 0 || key != prevKey) {
+            auto found = indices.find(key);
+            if (found == indices.end()) {
+                if (palette.size() == CHUNK_PALETTE_MAX_SIZE) {
+                    size = CHUNK_ENCODED_MAX_LEN;
+                    return encodePlain(voxels);
+                }
+                found = indices.emplace(key, palette.size()).first;
+                palette.push_back(voxels[i]);
+            }
+            prevKey = key;
+            prevIndex = found->second;
+        }
+        paletteIndices[i] = prevIndex;
+	}
+    uint bits = palette_index_bits(palette.size());
+    size = palette_encoded_size(palette.size(), bits);
+
+    ubyte* buffer = new ubyte[size];
+    size_t offset = 0;
+    buffer[offset++] = CHUNK_FORMAT_PALETTE;
+    buffer[offset++] = palette.size() >> 8;
+    buffer[offset++] = palette.size() & 0xFF;
+    for (const voxel& vox : palette) {
+        buffer[offset++] = vox.id >> 8;
+        buffer[offset++] = vox.id & 0xFF;
+        buffer[offset++] = vox.states >> 8;
+        buffer[offset++] = vox.states & 0xFF;
+    }
+    buffer[offset++] = bits;
+    ubyte* dst = buffer + offset;
+    switch (bits) {
+        case 1: pack_indices<1>(paletteIndices.get(), dst); break;
+        case 2: pack_indices<2>(paletteIndices.get(), dst); break;
+        case 4: pack_indices<4>(paletteIndices.get(), dst); break;
+        case 8: pack_indices<8>(paletteIndices.get(), dst); break;
+    }
+    return buffer;
 }
 
-bool Chunk::decode(const ubyte* data) {
+bool Chunk::decode(const ubyte* data, size_t size, voxel* voxels) {
+    if (size == 0) {
+        return false;
+    }
+    switch (data[0]) {
+        case CHUNK_FORMAT_PLAIN:
+            if (size != CHUNK_ENCODED_MAX_LEN) {
+                return false;
+            }
+            decodeLegacy(data + 1, voxels);
+            return true;
+        case CHUNK_FORMAT_PALETTE:
+            break;
+        default:
+            return false;
+    }
+    uint paletteSize, bits;
+    if (!read_palette_header(data, size, paletteSize, bits)) {
+        return false;
+    }
+    // palette is completed to 2^bits entries, so indices are checked
+    // once after unpacking
+    std::vector<voxel> palette(std::max(paletteSize, 256U));
+    size_t offset = 3;
+    for (uint i = 0; i < paletteSize; i++) {
+        voxel& vox = palette[i];
+        vox.id = (blockid_t(data[offset]) << 8) | data[offset+1];
+        vox.states = (blockstate_t(data[offset+2]) << 8) | data[offset+3];
+        offset += 4;
+    }
+    offset++;
+    if (bits == 0) {
+        for (uint i = 0; i < CHUNK_VOL; i++) {
+            voxels[i] = palette[0];
+        }
+        return true;
+    }
+    const ubyte* src = data + offset;
+    uint maxIndex = 0;
+    switch (bits) {
+        case 1: maxIndex = unpack_indices<1>(src, palette.data(), voxels); break;
+        case 2: maxIndex = unpack_indices<2>(src, palette.data(), voxels); break;
+        case 4: maxIndex = unpack_indices<4>(src, palette.data(), voxels); break;
+        case 8: maxIndex = unpack_indices<8>(src, palette.data(), voxels); break;
+    }
+    return maxIndex < paletteSize;
+}
+
+void Chunk::decodeLegacy(const ubyte* data, voxel* voxels) {
 	for (uint i = 0; i < CHUNK_VOL; i++) {
 		voxel& vox = voxels[i];
 
@@ -116,16 +380,54 @@ bool Chunk::decode(const ubyte* data) {
 		vox.id = (blockid_t(bid1) << 8) | (blockid_t(bid2));
         vox.states = (blockstate_t(bst1) << 8) | (blockstate_t(bst2));
 	}
-	return true;
 }
 
-void Chunk::convert(ubyte* data, const ContentLUT* lut) {
+ubyte* Chunk::encode(size_t& size) const {
+    // not value-initialized: all voxels are overwritten
+    std::unique_ptr<voxel[]> buffer (new voxel[CHUNK_VOL]);
+    voxels.get(buffer.get());
+    return encode(buffer.get(), size);
+}
+
+bool Chunk::decode(const ubyte* data, size_t size) {
+    std::unique_ptr<voxel[]> buffer (new voxel[CHUNK_VOL]);
+    if (!decode(data, size, buffer.get())) {
+        return false;
+    }
+    voxels.set(buffer.get());
+    return true;
+}
+
+bool Chunk::convert(ubyte* data, size_t size, const ContentLUT* lut) {
+    if (size == 0) {
+        return false;
+    }
+    if (data[0] == CHUNK_FORMAT_PALETTE) {
+        uint paletteSize, bits;
+        if (!read_palette_header(data, size, paletteSize, bits)) {
+            return false;
+        }
+        ubyte* palette = data + 3;
+        for (uint i = 0; i < paletteSize; i++) {
+            ubyte* entry = palette + i * 4;
+            blockid_t id = (blockid_t(entry[0]) << 8) | blockid_t(entry[1]);
+            blockid_t replacement = lut->getBlockId(id);
+            entry[0] = replacement >> 8;
+            entry[1] = replacement & 0xFF;
+        }
+        return true;
+    }
+    if (data[0] != CHUNK_FORMAT_PLAIN || size != CHUNK_ENCODED_MAX_LEN) {
+        return false;
+    }
+    data++;
     for (uint i = 0; i < CHUNK_VOL; i++) {
-        // see encode method to understand what the hell is going on here
+        // see encodePlain method to understand what the hell is going on here
         blockid_t id = ((blockid_t(data[i]) << 8) | 
                          blockid_t(data[CHUNK_VOL+i]));
         blockid_t replacement = lut->getBlockId(id);
         data[i] = replacement >> 8;
         data[CHUNK_VOL+i] = replacement & 0xFF;
     }
+    return true;
 }
@@ -8,6 +8,7 @@
 #include "../constants.h"
 #include "voxel.h"
 #include "../lighting/Lightmap.h"
+#include "../util/SectionedArray.h"
 
 struct ChunkFlag {
 	static const int MODIFIED = 0x1;
@@ -16,21 +17,57 @@ struct ChunkFlag {
 	static const int LIGHTED = 0x8;
 	static const int UNSAVED = 0x10;
 	static const int LOADED_LIGHTS = 0x20;
+	/// @brief Lights are being updated (see Lighting::update)
+	static const int LIGHT_DIRTY = 0x40;
+	/// @brief Lights cache of all channels is loaded (see Lightmap::encodeFull)
+	static const int LOADED_FULL_LIGHTS = 0x80;
+	/// @brief Lights changed after the chunk is loaded
+	static const int UNSAVED_LIGHTS = 0x100;
 };
+/// @brief Length of plain voxels data (see Chunk::encode)
 inline constexpr int CHUNK_DATA_LEN = CHUNK_VOL*4;
+/// @brief Max length of encoded voxels data (format byte + plain data)
+inline constexpr int CHUNK_ENCODED_MAX_LEN = CHUNK_DATA_LEN + 1;
+
+/// @brief Encoded voxels data formats (first byte of the data)
+inline constexpr ubyte CHUNK_FORMAT_PLAIN = 0;
+inline constexpr ubyte CHUNK_FORMAT_PALETTE = 1;
+/// @brief Max number of different voxels stored with palette 
+/// (plain format is used for chunks with more different voxels)
+inline constexpr uint CHUNK_PALETTE_MAX_SIZE = 256;
 
 class Lightmap;
 class ContentLUT;
+class ContentIndices;
 class Inventory;
 
+/// @brief Highest blocks of chunk columns (index is z * CHUNK_W + x).
+/// -1 is used for columns having no such blocks
+struct chunk_heightmap {
+    /// @brief Y of the highest not air block
+    int16_t blocks[CHUNK_W * CHUNK_D];
+    /// @brief Y of the highest block not passing sky light
+    int16_t skyLight[CHUNK_W * CHUNK_D];
+};
+
 using chunk_inventories_map = std::unordered_map<uint, std::shared_ptr<Inventory>>;
+using chunk_voxels = util::SectionedArray<voxel, CHUNK_SECTION_VOL, CHUNK_SECTIONS>;
 
 class Chunk {
+    /// @brief Find heightmap values of the column
+    void scanColumn(uint x, uint z, const ubyte* skyLightPassing);
+    /// @brief Update top using heightmap
+    void updateTop();
 public:
 	int x, z;
 	int bottom, top;
-	voxel voxels[CHUNK_VOL];
+    /// @brief Vertical sections filled with a single voxel are not 
+    /// allocated. Use voxels.set or voxels.getWriteable to modify
+	chunk_voxels voxels;
 	Lightmap lightmap;
+    /// @brief Calculated from voxels on chunk creation and kept updated
+    /// by Chunks::set
+    chunk_heightmap heightmap;
 	int flags = 0;
 
     /* Block inventories map where key is index of block in voxels array */
@@ -38,9 +75,17 @@ public:
 
 	Chunk(int x, int z);
 
+    /// @brief Prepare chunk for reuse at the new position
+    /// @param fill fill voxels and lights with default values
+    void reset(int x, int z, bool fill);
+
 	bool isEmpty();
 
-	void updateHeights();
+    /// @brief Calculate heightmap, bottom and top from voxels
+	void updateHeights(const ContentIndices* indices);
+
+    /// @brief Update heightmap column and top after voxel modification
+	void updateColumn(uint x, uint z, const ContentIndices* indices);
 
     // unused
 	std::unique_ptr<Chunk> clone() const;
@@ -75,6 +120,12 @@ public:
 
 	inline bool isReady() const {return flags & ChunkFlag::READY;}
 
+	inline bool isLightDirty() const {return flags & ChunkFlag::LIGHT_DIRTY;}
+
+	inline bool isLoadedFullLights() const {return flags & ChunkFlag::LOADED_FULL_LIGHTS;}
+
+	inline bool isUnsavedLights() const {return flags & ChunkFlag::UNSAVED_LIGHTS;}
+
 	inline void setUnsaved(bool newState) {setFlags(ChunkFlag::UNSAVED, newState);}
 
 	inline void setModified(bool newState) {setFlags(ChunkFlag::MODIFIED, newState);}
@@ -87,14 +138,50 @@ public:
 
 	inline void setReady(bool newState) {setFlags(ChunkFlag::READY, newState);}
 
-	ubyte* encode() const;
-
-    /**
-     * @return true if all is fine
-     **/
-	bool decode(const ubyte* data);
-
-    static void convert(ubyte* data, const ContentLUT* lut);
+	inline void setLightDirty(bool newState) {setFlags(ChunkFlag::LIGHT_DIRTY, newState);}
+
+	inline void setLoadedFullLights(bool newState) {setFlags(ChunkFlag::LOADED_FULL_LIGHTS, newState);}
+
+	inline void setUnsavedLights(bool newState) {setFlags(ChunkFlag::UNSAVED_LIGHTS, newState);}
+
+    /// @brief Encode chunk voxels (see static encode)
+    /// @param size (out argument) encoded data length
+    ubyte* encode(size_t& size) const;
+
+    /// @brief Decode chunk voxels (see static decode)
+    /// @param size encoded data length
+    /// @return true if all is fine
+	bool decode(const ubyte* data, size_t size);
+
+    /// @brief Encode voxels using palette format if chunk has up to
+    /// CHUNK_PALETTE_MAX_SIZE different voxels, plain format otherwise.
+    /// Palette format data is always shorter than plain one
+    /// @param voxels source voxels array of CHUNK_VOL length
+    /// @param size (out argument) encoded data length
+    /// @return encoded data (up to CHUNK_ENCODED_MAX_LEN bytes)
+    static ubyte* encode(const voxel* voxels, size_t& size);
+
+    /// @brief Encode voxels using plain format
+    /// @param voxels source voxels array of CHUNK_VOL length
+    /// @return encoded data of CHUNK_ENCODED_MAX_LEN bytes
+    static ubyte* encodePlain(const voxel* voxels);
+
+    /// @brief Decode voxels encoded with any of CHUNK_FORMAT_* formats
+    /// @param size encoded data length
+    /// @param voxels destination voxels array of CHUNK_VOL length
+    /// @return false if data format is invalid, data length does not
+    /// match the format or a palette index is out of the palette
+    static bool decode(const ubyte* data, size_t size, voxel* voxels);
+
+    /// @brief Decode voxels data stored in region files before format 
+    /// version 3 (plain format without format byte)
+    static void decodeLegacy(const ubyte* data, voxel* voxels);
+
+    /// @brief Replace block ids in encoded voxels data 
+    /// (only palette is changed if palette format is used)
+    /// @param size encoded data length
+    /// @return false if data format is invalid (data is not changed)
+    static bool convert(ubyte* data, size_t size, const ContentLUT* lut);
 };
 
 #endif /* VOXELS_CHUNK_H_ */
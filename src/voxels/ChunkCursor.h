@@ -0,0 +1,163 @@
+#ifndef VOXELS_CHUNK_CURSOR_H_
+#define VOXELS_CHUNK_CURSOR_H_
+
+#include "Chunk.h"
+#include "Chunks.h"
+#include "voxel.h"
+#include "../constants.h"
+#include "../typedefs.h"
+#include "../maths/voxmaths.h"
+
+/// @brief Non-owning voxels accessor remembering the last chunk accessed,
+/// so sequential access to nearby voxels does not look up the chunks
+/// matrix each time.
+/// Cursor also has a position (see moveTo) to step from and to access
+/// neighbours of with no chunk lookup inside of the same chunk.
+/// Must not outlive the operation it's created for: chunks matrix must
+/// not be moved and chunks must not be unloaded while cursor is used.
+class ChunkCursor {
+    Chunks& chunks;
+    Chunk* chunk = nullptr;
+    /// @brief Coords of the cached chunk (chunk may be nullptr if missing)
+    int32_t cx = 0, cz = 0;
+    bool valid = false;
+
+    /// @brief Chunk of the position or nullptr if not loaded
+    Chunk* posChunk = nullptr;
+    /// @brief Position global coords
+    int32_t px = 0, py = 0, pz = 0;
+    /// @brief Position coords local to posChunk
+    int32_t lx = 0, lz = 0;
+
+    static inline bool isLocal(int32_t x, int32_t y, int32_t z) {
+        return x >= 0 && x < CHUNK_W && y >= 0 && y < CHUNK_H &&
+               z >= 0 && z < CHUNK_D;
+    }
+public:
+    ChunkCursor(Chunks& chunks) : chunks(chunks) {}
+
+    /// @brief Get chunk containing the voxel
+    /// @return chunk or nullptr if chunk is not loaded or y is out of range
+    inline Chunk* getChunkByVoxel(int32_t x, int32_t y, int32_t z) {
+        if (y < 0 || y >= CHUNK_H) {
+            return nullptr;
+        }
+        int32_t ncx = floordiv(x, CHUNK_W);
+        int32_t ncz = floordiv(z, CHUNK_D);
+        if (!valid || ncx != cx || ncz != cz) {
+            chunk = chunks.getChunk(ncx, ncz);
+            cx = ncx;
+            cz = ncz;
+            valid = true;
+        }
+        return chunk;
+    }
+
+    /// @brief Get voxel (see Chunks::get)
+    /// @return voxel or nullptr if chunk is not loaded
+    inline const voxel* get(int32_t x, int32_t y, int32_t z) {
+        Chunk* chunk = getChunkByVoxel(x, y, z);
+        if (chunk == nullptr) {
+            return nullptr;
+        }
+        int32_t lx = x - cx * CHUNK_W;
+        int32_t lz = z - cz * CHUNK_D;
+        return &chunk->voxels[vox_index(lx, y, lz)];
+    }
+
+    /// @return light or 0 if chunk is not loaded
+    inline light_t getLight(int32_t x, int32_t y, int32_t z) {
+        Chunk* chunk = getChunkByVoxel(x, y, z);
+        if (chunk == nullptr) {
+            return 0;
+        }
+        return chunk->lightmap.get(x - cx * CHUNK_W, y, z - cz * CHUNK_D);
+    }
+
+    /// @return light channel value or 0 if chunk is not loaded
+    inline ubyte getLight(int32_t x, int32_t y, int32_t z, int channel) {
+        Chunk* chunk = getChunkByVoxel(x, y, z);
+        if (chunk == nullptr) {
+            return 0;
+        }
+        return chunk->lightmap.get(
+            x - cx * CHUNK_W, y, z - cz * CHUNK_D, channel
+        );
+    }
+
+    /// @brief Move the cursor position to the voxel
+    /// @return false if chunk is not loaded or y is out of range
+    inline bool moveTo(int32_t x, int32_t y, int32_t z) {
+        px = x;
+        py = y;
+        pz = z;
+        posChunk = getChunkByVoxel(x, y, z);
+        lx = x - cx * CHUNK_W;
+        lz = z - cz * CHUNK_D;
+        return posChunk != nullptr;
+    }
+
+    /// @brief Move the cursor position by the offset. Chunks matrix is 
+    /// not looked up if the position stays in the same chunk
+    /// @return false if chunk is not loaded or y is out of range
+    inline bool step(int32_t dx, int32_t dy, int32_t dz) {
+        int32_t nx = lx + dx;
+        int32_t ny = py + dy;
+        int32_t nz = lz + dz;
+        if (posChunk == nullptr || !isLocal(nx, ny, nz)) {
+            return moveTo(px + dx, py + dy, pz + dz);
+        }
+        px += dx;
+        py = ny;
+        pz += dz;
+        lx = nx;
+        lz = nz;
+        return true;
+    }
+
+    /// @return voxel at the cursor position or nullptr if chunk 
+    /// is not loaded
+    inline const voxel* current() const {
+        if (posChunk == nullptr) {
+            return nullptr;
+        }
+        return &posChunk->voxels[vox_index(lx, py, lz)];
+    }
+
+    /// @return light channel value at the cursor position or 0 
+    /// if chunk is not loaded
+    inline ubyte currentLight(int channel) const {
+        if (posChunk == nullptr) {
+            return 0;
+        }
+        return posChunk->lightmap.get(lx, py, lz, channel);
+    }
+
+    /// @brief Get voxel at the offset from the cursor position 
+    /// (cursor is not moved)
+    /// @return voxel or nullptr if chunk is not loaded
+    inline const voxel* neighbour(int32_t dx, int32_t dy, int32_t dz) {
+        int32_t nx = lx + dx;
+        int32_t ny = py + dy;
+        int32_t nz = lz + dz;
+        if (posChunk == nullptr || !isLocal(nx, ny, nz)) {
+            return get(px + dx, py + dy, pz + dz);
+        }
+        return &posChunk->voxels[vox_index(nx, ny, nz)];
+    }
+
+    /// @brief Get light channel value at the offset from the cursor 
+    /// position (cursor is not moved)
+    /// @return light channel value or 0 if chunk is not loaded
+    inline ubyte neighbourLight(int32_t dx, int32_t dy, int32_t dz, int channel) {
+        int32_t nx = lx + dx;
+        int32_t ny = py + dy;
+        int32_t nz = lz + dz;
+        if (posChunk == nullptr || !isLocal(nx, ny, nz)) {
+            return getLight(px + dx, py + dy, pz + dz, channel);
+        }
+        return posChunk->lightmap.get(nx, ny, nz, channel);
+    }
+};
+
+#endif // VOXELS_CHUNK_CURSOR_H_
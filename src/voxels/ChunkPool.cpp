@@ -0,0 +1,62 @@
+#include "ChunkPool.h"
+
+#include "Chunk.h"
+
+ChunkPool::ChunkPool(size_t capacity) : capacity(capacity) {
+}
+
+ChunkPool::~ChunkPool() {
+}
+
+std::shared_ptr<Chunk> ChunkPool::create(int x, int z, bool fill) {
+    std::unique_ptr<Chunk> chunk;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (chunks.empty()) {
+            misses++;
+        } else {
+            hits++;
+            chunk = std::move(chunks.back());
+            chunks.pop_back();
+        }
+    }
+    if (chunk == nullptr) {
+        chunk = std::make_unique<Chunk>(x, z);
+    } else {
+        chunk->reset(x, z, fill);
+    }
+    // pool may be destroyed before the chunk
+    std::weak_ptr<ChunkPool> weak = shared_from_this();
+    return std::shared_ptr<Chunk>(chunk.release(), [weak](Chunk* chunk) {
+        if (auto pool = weak.lock()) {
+            pool->release(chunk);
+        } else {
+            delete chunk;
+        }
+    });
+}
+
+void ChunkPool::release(Chunk* chunk) {
+    std::unique_ptr<Chunk> ptr (chunk);
+    // do not keep block inventories alive while pooled
+    ptr->inventories.clear();
+    std::lock_guard<std::mutex> lock(mutex);
+    if (chunks.size() < capacity) {
+        chunks.push_back(std::move(ptr));
+    }
+}
+
+size_t ChunkPool::getHits() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return hits;
+}
+
+size_t ChunkPool::getMisses() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return misses;
+}
+
+size_t ChunkPool::size() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return chunks.size();
+}
@@ -0,0 +1,44 @@
+#ifndef VOXELS_CHUNK_POOL_H_
+#define VOXELS_CHUNK_POOL_H_
+
+#include <mutex>
+#include <memory>
+#include <vector>
+
+#include "../typedefs.h"
+
+class Chunk;
+
+/// @brief Keeps chunks released by all owners for reuse, so moving through
+/// the world does not allocate and free chunks sections all the time.
+/// Chunks may be released from any thread.
+class ChunkPool : public std::enable_shared_from_this<ChunkPool> {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Chunk>> chunks;
+    size_t capacity;
+    size_t hits = 0;
+    size_t misses = 0;
+
+    void release(Chunk* chunk);
+public:
+    /// @param capacity max number of chunks kept for reuse
+    ChunkPool(size_t capacity);
+    ~ChunkPool();
+
+    /// @brief Get recycled or new chunk. Chunk returns to the pool
+    /// when the last reference is released
+    /// @param fill fill voxels and lights with default values.
+    /// Use false only if both will be overwritten entirely
+    std::shared_ptr<Chunk> create(int x, int z, bool fill=true);
+
+    /// @return number of chunks reused
+    size_t getHits();
+
+    /// @return number of chunks allocated
+    size_t getMisses();
+
+    /// @return number of chunks waiting for reuse
+    size_t size();
+};
+
+#endif // VOXELS_CHUNK_POOL_H_
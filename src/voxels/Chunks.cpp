@@ -1,5 +1,6 @@
 #include "Chunks.h"
 #include "Chunk.h"
+#include "ChunkCursor.h"
 #include "voxel.h"
 #include "Block.h"
 #include "WorldGenerator.h"
@@ -24,7 +25,6 @@ Chunks::Chunks(uint32_t w, uint32_t d,
 			   const Content* content) 
 		: contentIds(content->getIndices()), 
           chunks(w*d),
-          chunksSecond(w*d),
 		  w(w), d(d), ox(ox), oz(oz), 
 		  worldFiles(wfile), 
 		  events(events) {
@@ -32,7 +32,7 @@ Chunks::Chunks(uint32_t w, uint32_t d,
 	chunksCount = 0;
 }
 
-voxel* Chunks::get(int32_t x, int32_t y, int32_t z) {
+const voxel* Chunks::get(int32_t x, int32_t y, int32_t z) {
 	x -= ox * CHUNK_W; 
 	z -= oz * CHUNK_D;
 	int cx = floordiv(x, CHUNK_W);
@@ -40,7 +40,7 @@ voxel* Chunks::get(int32_t x, int32_t y, int32_t z) {
 	int cz = floordiv(z, CHUNK_D);
 	if (cx < 0 || cy < 0 || cz < 0 || cx >= int(w) || cy >= 1 || cz >= int(d))
 		return nullptr;
-	std::shared_ptr<Chunk> chunk = chunks[cz * w + cx];
+	Chunk* chunk = chunks[indexOf(cx + ox, cz + oz)].get();
 	if (chunk == nullptr)
 		return nullptr;
 	int lx = x - cx * CHUNK_W;
@@ -49,11 +49,33 @@ voxel* Chunks::get(int32_t x, int32_t y, int32_t z) {
 	return &chunk->voxels[(ly * CHUNK_D + lz) * CHUNK_W + lx];
 }
 
+voxel* Chunks::getWriteable(int32_t x, int32_t y, int32_t z) {
+	x -= ox * CHUNK_W; 
+	z -= oz * CHUNK_D;
+	int cx = floordiv(x, CHUNK_W);
+	int cy = floordiv(y, CHUNK_H);
+	int cz = floordiv(z, CHUNK_D);
+	if (cx < 0 || cy < 0 || cz < 0 || cx >= int(w) || cy >= 1 || cz >= int(d))
+		return nullptr;
+	Chunk* chunk = chunks[indexOf(cx + ox, cz + oz)].get();
+	if (chunk == nullptr)
+		return nullptr;
+	int lx = x - cx * CHUNK_W;
+	int ly = y - cy * CHUNK_H;
+	int lz = z - cz * CHUNK_D;
+	return &chunk->voxels.getWriteable((ly * CHUNK_D + lz) * CHUNK_W + lx);
+}
+
 const AABB* Chunks::isObstacleAt(float x, float y, float z){
+	ChunkCursor cursor(*this);
+	return isObstacleAt(cursor, x, y, z);
+}
+
+const AABB* Chunks::isObstacleAt(ChunkCursor& cursor, float x, float y, float z){
 	int ix = floor(x);
 	int iy = floor(y);
 	int iz = floor(z);
-	voxel* v = get(ix, iy, iz);
+	const voxel* v = cursor.get(ix, iy, iz);
 	if (v == nullptr) {
 		if (iy >= CHUNK_H) {
 			return nullptr;
@@ -62,8 +84,8 @@ const AABB* Chunks::isObstacleAt(float x, float y, float z){
 			return &empty;
 		}
     }
-	const Block* def = contentIds->getBlockDef(v->id);
-	if (def->obstacle) {
+	if (contentIds->getBlockProps().obstacle[v->id]) {
+		const Block* def = contentIds->getBlockDef(v->id);
         const auto& boxes = def->rotatable 
                          ? def->rt.hitboxes[v->rotation()] 
                          : def->hitboxes;
@@ -76,24 +98,24 @@ const AABB* Chunks::isObstacleAt(float x, float y, float z){
 }
 
 bool Chunks::isSolidBlock(int32_t x, int32_t y, int32_t z) {
-    voxel* v = get(x, y, z);
+    const voxel* v = get(x, y, z);
     if (v == nullptr)
         return false;
-    return contentIds->getBlockDef(v->id)->rt.solid;
+    return contentIds->getBlockProps().solid[v->id];
 }
 
 bool Chunks::isReplaceableBlock(int32_t x, int32_t y, int32_t z) {
-    voxel* v = get(x, y, z);
+    const voxel* v = get(x, y, z);
     if (v == nullptr)
         return false;
     return contentIds->getBlockDef(v->id)->replaceable;
 }
 
 bool Chunks::isObstacleBlock(int32_t x, int32_t y, int32_t z) {
-	voxel* v = get(x, y, z);
+	const voxel* v = get(x, y, z);
 	if (v == nullptr)
 		return false;
-	return contentIds->getBlockDef(v->id)->obstacle;
+	return contentIds->getBlockProps().obstacle[v->id];
 }
 
 ubyte Chunks::getLight(int32_t x, int32_t y, int32_t z, int channel){
@@ -104,7 +126,7 @@ ubyte Chunks::getLight(int32_t x, int32_t y, int32_t z, int channel){
 	int cz = floordiv(z, CHUNK_D);
 	if (cx < 0 || cy < 0 || cz < 0 || cx >= int(w) || cy >= 1 || cz >= int(d))
 		return 0;
-	auto chunk = chunks[(cy * d + cz) * w + cx];
+	Chunk* chunk = chunks[indexOf(cx + ox, cz + oz)].get();
 	if (chunk == nullptr)
 		return 0;
 	int lx = x - cx * CHUNK_W;
@@ -121,7 +143,7 @@ light_t Chunks::getLight(int32_t x, int32_t y, int32_t z){
 	int cz = floordiv(z, CHUNK_D);
 	if (cx < 0 || cy < 0 || cz < 0 || cx >= int(w) || cy >= 1 || cz >= int(d))
 		return 0;
-	auto chunk = chunks[(cy * d + cz) * w + cx];
+	Chunk* chunk = chunks[indexOf(cx + ox, cz + oz)].get();
 	if (chunk == nullptr)
 		return 0;
 	int lx = x - cx * CHUNK_W;
@@ -139,15 +161,13 @@ Chunk* Chunks::getChunkByVoxel(int32_t x, int32_t y, int32_t z){
 	int cz = floordiv(z, CHUNK_D);
 	if (cx < 0 || cz < 0 || cx >= int(w) || cz >= int(d))
 		return nullptr;
-	return chunks[cz * w + cx].get();
+	return chunks[indexOf(cx + ox, cz + oz)].get();
 }
 
 Chunk* Chunks::getChunk(int x, int z){
-	x -= ox;
-	z -= oz;
-	if (x < 0 || z < 0 || x >= int(w) || z >= int(d))
+	if (x < ox || z < oz || x >= ox + int(w) || z >= oz + int(d))
 		return nullptr;
-	return chunks[z * w + x].get();
+	return chunks[indexOf(x, z)].get();
 }
 
 void Chunks::set(int32_t x, int32_t y, int32_t z, uint32_t id, uint8_t states){
@@ -159,25 +179,23 @@ void Chunks::set(int32_t x, int32_t y, int32_t z, uint32_t id, uint8_t states){
 	int cz = floordiv(z, CHUNK_D);
 	if (cx < 0 || cz < 0 || cx >= int(w) || cz >= int(d))
 		return;
-	Chunk* chunk = chunks[cz * w + cx].get();
+	Chunk* chunk = chunks[indexOf(cx + ox, cz + oz)].get();
 	if (chunk == nullptr)
 		return;
 	int lx = x - cx * CHUNK_W;
 	int lz = z - cz * CHUNK_D;
     
-    voxel& vox = chunk->voxels[(y * CHUNK_D + lz) * CHUNK_W + lx]; 
-	auto def = contentIds->getBlockDef(vox.id);
+    size_t index = (y * CHUNK_D + lz) * CHUNK_W + lx;
+	auto def = contentIds->getBlockDef(chunk->voxels[index].id);
 	if (def->inventorySize == 0)
 		chunk->removeBlockInventory(lx, y, lz);
-	vox.id = id;
-	vox.states = states;
+	chunk->voxels.set(index, voxel {blockid_t(id), blockstate_t(states)});
 
 	chunk->setUnsaved(true);
 	chunk->setModified(true);
 
 	if (y < chunk->bottom) chunk->bottom = y;
-	else if (y + 1 > chunk->top) chunk->top = y + 1;
-	else if (id == 0) chunk->updateHeights();
+	chunk->updateColumn(lx, lz, contentIds);
 
 	if (lx == 0 && (chunk = getChunk(cx+ox-1, cz+oz)))
 		chunk->setModified(true);
@@ -190,7 +208,7 @@ void Chunks::set(int32_t x, int32_t y, int32_t z, uint32_t id, uint8_t states){
 		chunk->setModified(true);
 }
 
-voxel* Chunks::rayCast(glm::vec3 start, 
+const voxel* Chunks::rayCast(glm::vec3 start, 
 					   glm::vec3 dir, 
 					   float maxDist, 
 					   glm::vec3& end, 
@@ -205,9 +223,11 @@ voxel* Chunks::rayCast(glm::vec3 start,
 	float dz = dir.z;
 
 	float t = 0.0f;
+	ChunkCursor cursor(*this);
 	int ix = floor(px);
 	int iy = floor(py);
 	int iz = floor(pz);
+	cursor.moveTo(ix, iy, iz);
 
 	int stepx = (dx > 0.0f) ? 1 : -1;
 	int stepy = (dy > 0.0f) ? 1 : -1;
@@ -230,7 +250,7 @@ voxel* Chunks::rayCast(glm::vec3 start,
 	int steppedIndex = -1;      
                                 
 	while (t <= maxDist){       
-		voxel* voxel = get(ix, iy, iz);		
+		const voxel* voxel = cursor.current();		
 		if (voxel == nullptr){ return nullptr; }
 
 		const Block* def = contentIds->getBlockDef(voxel->id);
@@ -279,11 +299,13 @@ voxel* Chunks::rayCast(glm::vec3 start,
 		if (txMax < tyMax) {
 			if (txMax < tzMax) {
 				ix += stepx;
+				cursor.step(stepx, 0, 0);
 				t = txMax;
 				txMax += txDelta;
 				steppedIndex = 0;
 			} else {
 				iz += stepz;
+				cursor.step(0, 0, stepz);
 				t = tzMax;
 				tzMax += tzDelta;
 				steppedIndex = 2;
@@ -291,11 +313,13 @@ voxel* Chunks::rayCast(glm::vec3 start,
 		} else {
 			if (tyMax < tzMax) {
 				iy += stepy;
+				cursor.step(0, stepy, 0);
 				t = tyMax;
 				tyMax += tyDelta;
 				steppedIndex = 1;
 			} else {
 				iz += stepz;
+				cursor.step(0, 0, stepz);
 				t = tzMax;
 				tzMax += tzDelta;
 				steppedIndex = 2;
@@ -323,9 +347,11 @@ glm::vec3 Chunks::rayCastToObstacle(glm::vec3 start, glm::vec3 dir, float maxDis
 	float dz = dir.z;
 
 	float t = 0.0f;
+	ChunkCursor cursor(*this);
 	int ix = floor(px);
 	int iy = floor(py);
 	int iz = floor(pz);
+	cursor.moveTo(ix, iy, iz);
 
 	int stepx = (dx > 0.0f) ? 1 : -1;
 	int stepy = (dy > 0.0f) ? 1 : -1;
@@ -346,7 +372,7 @@ glm::vec3 Chunks::rayCastToObstacle(glm::vec3 start, glm::vec3 dir, float maxDis
 	float tzMax = (tzDelta < infinity) ? tzDelta * zdist : infinity;
 
 	while (t <= maxDist) {
-		voxel* voxel = get(ix, iy, iz);
+		const voxel* voxel = cursor.current();
 		if (voxel == nullptr) { return glm::vec3(px + t * dx, py + t * dy, pz + t * dz); }
 
 		const Block* def = contentIds->getBlockDef(voxel->id);
@@ -374,11 +400,13 @@ glm::vec3 Chunks::rayCastToObstacle(glm::vec3 start, glm::vec3 dir, float maxDis
 		if (txMax < tyMax) {
 			if (txMax < tzMax) {
 				ix += stepx;
+				cursor.step(stepx, 0, 0);
 				t = txMax;
 				txMax += txDelta;
 			}
 			else {
 				iz += stepz;
+				cursor.step(0, 0, stepz);
 				t = tzMax;
 				tzMax += tzDelta;
 			}
@@ -386,11 +414,13 @@ glm::vec3 Chunks::rayCastToObstacle(glm::vec3 start, glm::vec3 dir, float maxDis
 		else {
 			if (tyMax < tzMax) {
 				iy += stepy;
+				cursor.step(0, stepy, 0);
 				t = tyMax;
 				tyMax += tyDelta;
 			}
 			else {
 				iz += stepz;
+				cursor.step(0, 0, stepz);
 				t = tzMax;
 				tzMax += tzDelta;
 			}
@@ -410,59 +440,69 @@ void Chunks::setCenter(int32_t x, int32_t z) {
 	}
 }
 
+void Chunks::unload(std::shared_ptr<Chunk>& chunk) {
+	if (chunk == nullptr)
+		return;
+	events->trigger(EVT_CHUNK_HIDDEN, chunk.get());
+	if (worldFiles)
+		worldFiles->put(chunk.get());
+	chunksCount--;
+	chunk = nullptr;
+}
+
 void Chunks::translate(int32_t dx, int32_t dz) {
-	for (uint i = 0; i < volume; i++){
-		chunksSecond[i] = nullptr;
-	}
-	for (uint32_t z = 0; z < d; z++){
-		for (uint32_t x = 0; x < w; x++){
-			auto chunk = chunks[z * w + x];
-			int nx = x - dx;
-			int nz = z - dz;
-			if (chunk == nullptr)
-				continue;
-			if (nx < 0 || nz < 0 || nx >= int(w) || nz >= int(d)){
-				events->trigger(EVT_CHUNK_HIDDEN, chunk.get());
-				if (worldFiles)
-					worldFiles->put(chunk.get());
-				chunksCount--;
-				continue;
+	// chunks keep their places, so only ones left the matrix are touched
+	int32_t nox = ox + dx;
+	int32_t noz = oz + dz;
+	if (uint32_t(std::abs(dx)) >= w || uint32_t(std::abs(dz)) >= d) {
+		for (auto& chunk : chunks) {
+			unload(chunk);
+		}
+	} else {
+		// columns left
+		int32_t x1 = dx > 0 ? ox : nox + w;
+		int32_t x2 = dx > 0 ? nox : ox + w;
+		for (int32_t x = x1; x < x2; x++) {
+			for (int32_t z = oz; z < oz + int32_t(d); z++) {
+				unload(chunks[indexOf(x, z)]);
+			}
+		}
+		// rows left
+		int32_t z1 = dz > 0 ? oz : noz + d;
+		int32_t z2 = dz > 0 ? noz : oz + d;
+		for (int32_t z = z1; z < z2; z++) {
+			for (int32_t x = ox; x < ox + int32_t(w); x++) {
+				unload(chunks[indexOf(x, z)]);
 			}
-			chunksSecond[nz * w + nx] = chunk;
 		}
 	}
-	std::swap(chunks, chunksSecond);
-
-	ox += dx;
-	oz += dz;
+	ox = nox;
+	oz = noz;
 }
 
 void Chunks::resize(uint32_t newW, uint32_t newD) {
-	if (newW < w) {
-		int delta = w - newW;
-		translate(delta / 2, 0);
-		translate(-delta, 0);
-		translate(delta, 0);
-	}
-	if (newD < d) {
-		int delta = d - newD;
-		translate(0, delta / 2);
-		translate(0, -delta);
-		translate(0, delta);
-	}
-	const int newVolume = newW * newD;
-    std::vector<std::shared_ptr<Chunk>> newChunks(newVolume);
-    std::vector<std::shared_ptr<Chunk>> newChunksSecond(newVolume);
-	for (int z = 0; z < int(d) && z < int(newD); z++) {
-		for (int x = 0; x < int(w) && x < int(newW); x++) {
-			newChunks[z * newW + x] = chunks[z * w + x];
+	events->trigger(EVT_CHUNKS_MOVE, nullptr);
+	// matrix is shrunk to the center
+	int32_t nox = newW < w ? ox + int32_t(w - newW) / 2 : ox;
+	int32_t noz = newD < d ? oz + int32_t(d - newD) / 2 : oz;
+	std::vector<std::shared_ptr<Chunk>> newChunks(newW * newD);
+	for (auto& chunk : chunks) {
+		if (chunk == nullptr)
+			continue;
+		int32_t x = chunk->x - nox;
+		int32_t z = chunk->z - noz;
+		if (x < 0 || z < 0 || x >= int32_t(newW) || z >= int32_t(newD)) {
+			unload(chunk);
+			continue;
 		}
+		newChunks[indexOf(chunk->x, chunk->z, newW, newD)] = std::move(chunk);
 	}
-    w = newW;
-    d = newD;
-    volume = newVolume;
-    chunks = std::move(newChunks);
-    chunksSecond = std::move(newChunksSecond);
+	w = newW;
+	d = newD;
+	ox = nox;
+	oz = noz;
+	volume = size_t(w) * size_t(d);
+	chunks = std::move(newChunks);
 }
 
 void Chunks::_setOffset(int32_t x, int32_t z) {
@@ -473,16 +513,17 @@ void Chunks::_setOffset(int32_t x, int32_t z) {
 bool Chunks::putChunk(std::shared_ptr<Chunk> chunk) {
 	int x = chunk->x;
 	int z = chunk->z;
-	x -= ox;
-	z -= oz;
-	if (x < 0 || z < 0 || x >= int(w) || z >= int(d))
+	if (x < ox || z < oz || x >= ox + int(w) || z >= oz + int(d))
 		return false;
-	chunks[z * w + x] = chunk;
-	chunksCount++;
+	auto& slot = chunks[indexOf(x, z)];
+	if (slot == nullptr)
+		chunksCount++;
+	slot = chunk;
 	return true;
 }
 
 void Chunks::saveAndClear(){
+	events->trigger(EVT_CHUNKS_MOVE, nullptr);
 	for (size_t i = 0; i < volume; i++){
 		Chunk* chunk = chunks[i].get();
 		if (chunk) {
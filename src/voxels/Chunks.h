@@ -13,6 +13,7 @@ struct AABB;
 class Content;
 class ContentIndices;
 class Chunk;
+class ChunkCursor;
 struct voxel;
 class WorldFiles;
 class LevelEvents;
@@ -20,9 +21,13 @@ class LevelEvents;
 /* Player-centred chunks matrix */
 class Chunks {
 	const ContentIndices* const contentIds;
+
+	/// @brief Save chunk and remove it from the matrix
+	void unload(std::shared_ptr<Chunk>& chunk);
 public:
+	/// @brief Toroidal matrix: chunk place depends on its coords only
+	/// (see indexOf), so chunks are not moved when the matrix is moved
 	std::vector<std::shared_ptr<Chunk>> chunks;
-	std::vector<std::shared_ptr<Chunk>> chunksSecond;
 	size_t volume;
 	size_t chunksCount;
 	size_t visible;
@@ -35,16 +40,35 @@ public:
 		   WorldFiles* worldFiles, LevelEvents* events, const Content* content);
 	~Chunks() = default;
 
+	/// @brief Index of chunk in toroidal matrix of the given size
+	static inline size_t indexOf(int32_t x, int32_t z, uint32_t w, uint32_t d) {
+		int32_t mx = x % int32_t(w);
+		int32_t mz = z % int32_t(d);
+		if (mx < 0) mx += w;
+		if (mz < 0) mz += d;
+		return size_t(mz) * w + mx;
+	}
+
+	/// @brief Index of chunk in the chunks vector
+	/// @param x chunk x coord (must be inside of the matrix)
+	/// @param z chunk z coord (must be inside of the matrix)
+	inline size_t indexOf(int32_t x, int32_t z) const {
+		return indexOf(x, z, w, d);
+	}
+
 	bool putChunk(std::shared_ptr<Chunk> chunk);
 
 	Chunk* getChunk(int32_t x, int32_t z);
 	Chunk* getChunkByVoxel(int32_t x, int32_t y, int32_t z);
-	voxel* get(int32_t x, int32_t y, int32_t z);
+	const voxel* get(int32_t x, int32_t y, int32_t z);
+	/// @brief Get voxel for in-place modification
+	/// (allocates the chunk section containing the voxel)
+	voxel* getWriteable(int32_t x, int32_t y, int32_t z);
 	light_t getLight(int32_t x, int32_t y, int32_t z);
 	ubyte getLight(int32_t x, int32_t y, int32_t z, int channel);
 	void set(int32_t x, int32_t y, int32_t z, uint32_t id, uint8_t states);
 
-	voxel* rayCast(glm::vec3 start, 
+	const voxel* rayCast(glm::vec3 start, 
 				   glm::vec3 dir, 
 				   float maxLength, 
 				   glm::vec3& end, 
@@ -54,6 +78,8 @@ public:
 	glm::vec3 rayCastToObstacle(glm::vec3 start, glm::vec3 dir, float maxDist);
 
 	const AABB* isObstacleAt(float x, float y, float z);
+	/// @brief isObstacleAt for series of checks in one area
+	const AABB* isObstacleAt(ChunkCursor& cursor, float x, float y, float z);
     bool isSolidBlock(int32_t x, int32_t y, int32_t z);
     bool isReplaceableBlock(int32_t x, int32_t y, int32_t z);
 	bool isObstacleBlock(int32_t x, int32_t y, int32_t z);
@@ -5,6 +5,7 @@
 
 #include "VoxelsVolume.h"
 #include "Chunk.h"
+#include "ChunkPool.h"
 #include "Block.h"
 #include "../content/Content.h"
 #include "../files/WorldFiles.h"
@@ -15,7 +16,14 @@
 #include "../items/Inventories.h"
 #include "../typedefs.h"
 
-ChunksStorage::ChunksStorage(Level* level) : level(level) {
+/// @brief Max number of unloaded chunks kept for reuse
+inline constexpr size_t CHUNK_POOL_CAPACITY = 64;
+
+ChunksStorage::ChunksStorage(Level* level) 
+    : level(level), pool(std::make_shared<ChunkPool>(CHUNK_POOL_CAPACITY)) {
+}
+
+ChunksStorage::~ChunksStorage() {
 }
 
 void ChunksStorage::store(std::shared_ptr<Chunk> chunk) {
@@ -30,6 +38,10 @@ std::shared_ptr<Chunk> ChunksStorage::get(int x, int z) const {
 	return found->second;
 }
 
+ChunkPool* ChunksStorage::getPool() const {
+	return pool.get();
+}
+
 void ChunksStorage::remove(int x, int z) {
 	auto found = chunksMap.find(glm::ivec2(x, z));
 	if (found != chunksMap.end()) {
@@ -44,22 +56,25 @@ static void verifyLoadedChunk(ContentIndices* indices, Chunk* chunk) {
             std::cout << "corruped block detected at " << i << " of chunk ";
             std::cout << chunk->x << "x" << chunk->z;
             std::cout << " -> " << (int)id << std::endl;
-            chunk->voxels[i].id = 11;
+            chunk->voxels.getWriteable(i).id = 11;
         }
     }
 }
 
 std::shared_ptr<Chunk> ChunksStorage::create(int x, int z) {
 	World* world = level->getWorld();
-    WorldFiles* wfile = world->wfile.get();
-
-    auto chunk = std::make_shared<Chunk>(x, z);
-	store(chunk);
-	std::unique_ptr<ubyte[]> data(wfile->getChunk(chunk->x, chunk->z));
-	if (data) {
-		chunk->decode(data.get());
-		auto invs = wfile->fetchInventories(chunk->x, chunk->z);
-		chunk->setBlockInventories(std::move(invs));
+	auto data = world->wfile->loadChunk(x, z);
+	return create(data);
+}
+
+std::shared_ptr<Chunk> ChunksStorage::create(loaded_chunk& data) {
+	// voxels are decoded or generated, lights are loaded or built
+	auto chunk = pool->create(data.x, data.z, false);
+	if (data.voxels) {
+		if (!chunk->decode(data.voxels.get(), data.voxelsSize)) {
+			chunk->voxels.fill(voxel {2, 0});
+		}
+		chunk->setBlockInventories(std::move(data.inventories));
 		chunk->setLoaded(true);
 		for(auto& entry : chunk->inventories) {
 			level->inventories->store(entry.second);
@@ -67,10 +82,12 @@ std::shared_ptr<Chunk> ChunksStorage::create(int x, int z) {
         verifyLoadedChunk(level->content->getIndices(), chunk.get());
 	}
 
-	std::unique_ptr<light_t[]> lights (wfile->getLights(chunk->x, chunk->z));
-	if (lights) {
-		chunk->lightmap.set(lights.get());
+	if (data.lights) {
+		chunk->lightmap.set(data.lights.get());
 		chunk->setLoadedLights(true);
+		chunk->setLoadedFullLights(data.fullLights);
+	} else {
+		chunk->lightmap.map.fill(0);
 	}
 	return chunk;
 }
@@ -78,7 +95,7 @@ std::shared_ptr<Chunk> ChunksStorage::create(int x, int z) {
 // reduce nesting on next modification
 void ChunksStorage::getVoxels(VoxelsVolume* volume, bool backlight) const {
 	const Content* content = level->content;
-	auto indices = content->getIndices();
+	const ubyte* lightPassing = content->getIndices()->getBlockProps().lightPassing.data();
 	voxel* voxels = volume->getVoxels();
 	light_t* lights = volume->getLights();
 	int x = volume->getX();
@@ -119,8 +136,8 @@ void ChunksStorage::getVoxels(VoxelsVolume* volume, bool backlight) const {
 				}
 			} else {
 				auto& chunk = found->second;
-				const voxel* cvoxels = chunk->voxels;
-				const light_t* clights = chunk->lightmap.getLights();
+				const auto& cvoxels = chunk->voxels;
+				const auto& clights = chunk->lightmap.map;
 				for (int ly = y; ly < y + h; ly++) {
 					for (int lz = max(z, cz * CHUNK_D);
 						lz < min(z + d, (cz + 1) * CHUNK_D);
@@ -134,8 +151,7 @@ void ChunksStorage::getVoxels(VoxelsVolume* volume, bool backlight) const {
 							voxels[vidx] = cvoxels[cidx];
 							light_t light = clights[cidx];
 							if (backlight) {
-								const Block* block = indices->getBlockDef(voxels[vidx].id);
-								if (block->lightPassing) {
+								if (lightPassing[voxels[vidx].id]) {
 									light = Lightmap::combine(
 										min(15, Lightmap::extract(light, 0)+1),
 										min(15, Lightmap::extract(light, 1)+1),
@@ -10,23 +10,34 @@
 #include "glm/gtx/hash.hpp"
 
 class Chunk;
+class ChunkPool;
 class Level;
 class VoxelsVolume;
+struct loaded_chunk;
 
 class ChunksStorage {
 	Level* level;
 	std::unordered_map<glm::ivec2, std::shared_ptr<Chunk>> chunksMap;
+	std::shared_ptr<ChunkPool> pool;
 public:
 	ChunksStorage(Level* level);
-	~ChunksStorage() = default;
+	~ChunksStorage();
 
 	std::shared_ptr<Chunk> get(int x, int z) const;
 	void store(std::shared_ptr<Chunk> chunk);
 	void remove(int x, int y);
 	void getVoxels(VoxelsVolume* volume, bool backlight=false) const;
+	/// @brief Create chunk from world files. Chunk is not stored:
+	/// store it when all its data is set, as mesh threads read 
+	/// stored chunks
 	std::shared_ptr<Chunk> create(int x, int z);
+	/// @brief Create chunk from data read by WorldFiles (not stored)
+	/// @param data chunk data (voxels, lights and inventories are moved)
+	std::shared_ptr<Chunk> create(loaded_chunk& data);
 
 	light_t getLight(int x, int y, int z, ubyte channel) const;
+
+	ChunkPool* getPool() const;
 };
 
 
@@ -0,0 +1,56 @@
+#include "ColumnMapsCache.h"
+
+#include "../constants.h"
+
+ColumnMapsCache::ColumnMapsCache(uint mapsCount, size_t capacity)
+    : mapsCount(mapsCount), capacity(capacity) {
+}
+
+column_maps_tile ColumnMapsCache::getTile(
+    int seed, int tx, int tz, const column_func& compute
+) {
+    glm::ivec3 key (tx, tz, seed);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = tiles.find(key);
+        if (found != tiles.end()) {
+            hits++;
+            auto& entry = found->second;
+            tilesUsage.splice(tilesUsage.begin(), tilesUsage, entry.usage);
+            return entry.maps;
+        }
+        misses++;
+    }
+    std::shared_ptr<float[]> maps (new float[CHUNK_W * CHUNK_D * mapsCount]);
+    float* values = maps.get();
+    for (int z = 0; z < CHUNK_D; z++) {
+        for (int x = 0; x < CHUNK_W; x++) {
+            compute(tx * CHUNK_W + x, tz * CHUNK_D + z, values);
+            values += mapsCount;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    // the same tile may be computed by another thread meanwhile
+    auto found = tiles.find(key);
+    if (found != tiles.end()) {
+        return found->second.maps;
+    }
+    if (tiles.size() >= capacity) {
+        tiles.erase(tilesUsage.back());
+        tilesUsage.pop_back();
+    }
+    tilesUsage.push_front(key);
+    tiles[key] = cached_tile {maps, tilesUsage.begin()};
+    return maps;
+}
+
+size_t ColumnMapsCache::getHits() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return hits;
+}
+
+size_t ColumnMapsCache::getMisses() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return misses;
+}
@@ -0,0 +1,62 @@
+#ifndef VOXELS_COLUMN_MAPS_CACHE_H_
+#define VOXELS_COLUMN_MAPS_CACHE_H_
+
+#include <list>
+#include <mutex>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include <glm/glm.hpp>
+#define GLM_ENABLE_EXPERIMENTAL
+#include "glm/gtx/hash.hpp"
+
+#include "../typedefs.h"
+
+/// @brief Per-column values (height, climate maps) of a CHUNK_W x CHUNK_D
+/// columns tile, stored as [z][x][map]
+using column_maps_tile = std::shared_ptr<const float[]>;
+
+/// @brief Generator-side cache of 2D maps computed once per world column.
+/// Chunks generated with padding around themselves share the tiles
+/// of neighbour chunks instead of computing the padding columns again.
+/// Safe to use from multiple generation threads
+class ColumnMapsCache {
+public:
+    /// @brief Compute all maps values of the world column (x, z)
+    using column_func = std::function<void(int x, int z, float* values)>;
+private:
+    struct cached_tile {
+        column_maps_tile maps;
+        /// @brief Position in the recently used tiles list
+        std::list<glm::ivec3>::iterator usage;
+    };
+    const uint mapsCount;
+    const size_t capacity;
+    /// @brief Tiles by (tile x, tile z, world seed)
+    std::unordered_map<glm::ivec3, cached_tile> tiles;
+    /// @brief Cached tiles keys, the most recently used first
+    std::list<glm::ivec3> tilesUsage;
+    size_t hits = 0;
+    size_t misses = 0;
+    std::mutex mutex;
+public:
+    /// @param mapsCount number of values per column
+    /// @param capacity max tiles kept (least recently used are evicted)
+    ColumnMapsCache(uint mapsCount, size_t capacity);
+
+    /// @brief Get maps of the tile, computing it if not cached.
+    /// Tile is computed outside of the lock, so tiles needed by different
+    /// threads are computed in parallel
+    /// @param tx tile x (world column x / CHUNK_W)
+    /// @param tz tile z (world column z / CHUNK_D)
+    column_maps_tile getTile(int seed, int tx, int tz, const column_func& compute);
+
+    inline uint getMapsCount() const {
+        return mapsCount;
+    }
+
+    size_t getHits();
+    size_t getMisses();
+};
+
+#endif // VOXELS_COLUMN_MAPS_CACHE_H_
@@ -17,11 +17,13 @@
 #include "../maths/util.h"
 #include "../core_defs.h"
 
-void CubicWorldGenerator::generate(voxel* voxels, int cx, int cz, int seed) {
+void CubicWorldGenerator::generate(voxel* voxels, generator_context& context) const {
+    const int cx = context.cx;
+    const int cz = context.cz;
 
     int padding = 8;
 
-    float height = rand() % 59 + 1;
+    float height = context.random() % 59 + 1;
 
     float height2 = height;
 
@@ -33,7 +35,7 @@ void CubicWorldGenerator::generate(voxel* voxels, int cx, int cz, int seed) {
         for (int x = -padding; x < CHUNK_W + padding; x++) {
             int cur_x = x + cx * CHUNK_W;
             int cur_z = z + cz * CHUNK_D;
-            float height = rand() % 69 + 1;
+            float height = context.random() % 69 + 1;
             float w = pow(fmax(-abs(height - SEA_LEVEL) + 4, 0) / 6, 2);
             float h1 = -abs(height - SEA_LEVEL - 0.03);
             float h2 = abs(height - SEA_LEVEL + 0.04);
@@ -47,7 +49,7 @@ void CubicWorldGenerator::generate(voxel* voxels, int cx, int cz, int seed) {
         for (int x = 0; x < CHUNK_W; x++) {
             int cur_x = x + cx * CHUNK_W;
             while (!go) {
-                float height = rand() % 49 + 1;
+                float height = context.random() % 49 + 1;
                 if (height < 45) {
                 }
                 else
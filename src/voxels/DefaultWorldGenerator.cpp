@@ -8,6 +8,7 @@
 #include <time.h>
 #include <stdexcept>
 #include <math.h>
+#include <algorithm>
 #include <glm/glm.hpp>
 #include <glm/gtc/noise.hpp>
 #define FNL_IMPL
@@ -17,10 +18,13 @@
 #include "../maths/voxmaths.h"
 #include "../maths/util.h"
 #include "../core_defs.h"
+#include "ColumnMapsCache.h"
 
 // TODO: do something with long conditions + move magic numbers to constants
 
 const int SEA_LEVEL = 55;
+/// @brief Max column maps tiles cached (4 KB each)
+const size_t COLUMN_MAPS_CACHE_TILES = 512;
 
 enum class MAPS {
     SAND,
@@ -53,6 +57,25 @@ public:
         return heights[(int)map][z * w + x];
     }
 
+    /// @brief Copy part of the columns tile overlapping the map
+    /// @param tile MAPS_LEN values per column, stored as [z][x][map]
+    void fill(int tileX, int tileZ, int tileW, int tileD, const float* tile) {
+        int x0 = std::max(x, tileX);
+        int z0 = std::max(z, tileZ);
+        int x1 = std::min(x + w, tileX + tileW);
+        int z1 = std::min(z + d, tileZ + tileD);
+        for (int tz = z0; tz < z1; tz++) {
+            for (int tx = x0; tx < x1; tx++) {
+                const float* values = tile + 
+                    ((tz - tileZ) * tileW + (tx - tileX)) * MAPS_LEN;
+                int index = (tz - z) * w + (tx - x);
+                for (int i = 0; i < MAPS_LEN; i++) {
+                    heights[i][index] = values[i];
+                }
+            }
+        }
+    }
+
     inline void set(MAPS map, int x, int z, float value) {
         x -= this->x;
         z -= this->z;
@@ -80,15 +103,21 @@ float calc_height(FastNoiseLite& noise, int cur_x, int cur_z) {
     return height;
 }
 
-int generate_tree(FastNoiseLite& noise,
-    PseudoRandom* random,
+/// @brief Tree of the trees tile containing a column
+struct tree_column {
+    bool exists;
+    /// @brief Tree base height
+    int height;
+    /// @brief Column position relative to the tree trunk
+    int lx, lz;
+    int radius;
+};
+
+tree_column get_tree_column(PseudoRandom* random,
     Map2D& heights,
     int cur_x,
-    int cur_y,
     int cur_z,
-    int tileSize,
-    blockid_t idWood,
-    blockid_t idLeaves) {
+    int tileSize) {
     const int tileX = floordiv(cur_x, tileSize);
     const int tileZ = floordiv(cur_z, tileSize);
 
@@ -102,15 +131,26 @@ int generate_tree(FastNoiseLite& noise,
 
     bool gentree = (random->rand() % 10) < heights.get(MAPS::TREE, centerX, centerZ) * 13;
     if (!gentree)
-        return 0;
+        return tree_column {};
 
     int height = (int)(heights.get(MAPS::HEIGHT, centerX, centerZ));
     if (height < SEA_LEVEL + 1)
-        return 0;
-    int lx = cur_x - centerX;
+        return tree_column {};
     int radius = random->rand() % 4 + 2;
+    return tree_column {true, height, cur_x - centerX, cur_z - centerZ, radius};
+}
+
+int generate_tree(const tree_column& tree,
+    int cur_y,
+    blockid_t idWood,
+    blockid_t idLeaves) {
+    if (!tree.exists)
+        return 0;
+    int height = tree.height;
+    int radius = tree.radius;
+    int lx = tree.lx;
     int ly = cur_y - height - 3 * radius;
-    int lz = cur_z - centerZ;
+    int lz = tree.lz;
     if (lx == 0 && lz == 0 && cur_y - height < (3 * radius + radius / 2))
         return idWood;
     if (lx * lx + ly * ly / 2 + lz * lz < radius * radius)
@@ -118,36 +158,50 @@ int generate_tree(FastNoiseLite& noise,
     return 0;
 }
 
-void DefaultWorldGenerator::generate(voxel* voxels, int cx, int cz, int seed) {
+DefaultWorldGenerator::DefaultWorldGenerator(const Content* content)
+    : WorldGenerator(content), 
+      columnMaps(std::make_unique<ColumnMapsCache>(MAPS_LEN, COLUMN_MAPS_CACHE_TILES)) {
+}
+
+DefaultWorldGenerator::~DefaultWorldGenerator() {
+}
+
+void DefaultWorldGenerator::generate(voxel* voxels, generator_context& context) const {
+    const int cx = context.cx;
+    const int cz = context.cz;
     const int treesTile = 12;
     FastNoiseLite noise;
-    noise.SetSeed(seed * 60617077 % 25896307);
+    noise.SetSeed(context.seed * 60617077 % 25896307);
     noise.SetNoiseType(FastNoiseLite::NoiseType::NoiseType_OpenSimplex2);
     PseudoRandom randomtree;
     PseudoRandom randomgrass;
 
+    auto computeColumn = [&noise](int cur_x, int cur_z, float* values) {
+        float height = calc_height(noise, cur_x, cur_z);
+        float hum = noise.GetNoise(cur_x * 0.3 + 633, cur_z * 0.3);
+        float sand = noise.GetNoise(cur_x * 0.1 - 633, cur_z * 0.1 + 1000);
+        float cliff = pow((sand + abs(sand)) / 2, 2);
+        float w = pow(fmax(-abs(height - SEA_LEVEL) + 4, 0) / 6, 2) * cliff;
+        float h1 = -abs(height - SEA_LEVEL - 0.03);
+        float h2 = abs(height - SEA_LEVEL + 0.04);
+        float h = (h1 + h2) * 100;
+        height += (h * w);
+        values[(int)MAPS::HEIGHT] = height;
+        values[(int)MAPS::TREE] = hum;
+        values[(int)MAPS::SAND] = sand;
+        values[(int)MAPS::CLIFF] = cliff;
+    };
+
+    // trees of the neighbour chunks may reach this one
     int padding = 8;
     Map2D heights(cx * CHUNK_W - padding,
         cz * CHUNK_D - padding,
         CHUNK_W + padding * 2,
         CHUNK_D + padding * 2);
-    for (int z = -padding; z < CHUNK_D + padding; z++) {
-        for (int x = -padding; x < CHUNK_W + padding; x++) {
-            int cur_x = x + cx * CHUNK_W;
-            int cur_z = z + cz * CHUNK_D;
-            float height = calc_height(noise, cur_x, cur_z);
-            float hum = noise.GetNoise(cur_x * 0.3 + 633, cur_z * 0.3);
-            float sand = noise.GetNoise(cur_x * 0.1 - 633, cur_z * 0.1 + 1000);
-            float cliff = pow((sand + abs(sand)) / 2, 2);
-            float w = pow(fmax(-abs(height - SEA_LEVEL) + 4, 0) / 6, 2) * cliff;
-            float h1 = -abs(height - SEA_LEVEL - 0.03);
-            float h2 = abs(height - SEA_LEVEL + 0.04);
-            float h = (h1 + h2) * 100;
-            height += (h * w);
-            heights.set(MAPS::HEIGHT, cur_x, cur_z, height);
-            heights.set(MAPS::TREE, cur_x, cur_z, hum);
-            heights.set(MAPS::SAND, cur_x, cur_z, sand);
-            heights.set(MAPS::CLIFF, cur_x, cur_z, cliff);
+    for (int tz = cz - 1; tz <= cz + 1; tz++) {
+        for (int tx = cx - 1; tx <= cx + 1; tx++) {
+            auto tile = columnMaps->getTile(context.seed, tx, tz, computeColumn);
+            heights.fill(tx * CHUNK_W, tz * CHUNK_D, CHUNK_W, CHUNK_D, tile.get());
         }
     }
 
@@ -156,6 +210,11 @@ void DefaultWorldGenerator::generate(voxel* voxels, int cx, int cz, int seed) {
         for (int x = 0; x < CHUNK_W; x++) {
             int cur_x = x + cx * CHUNK_W;
             float height = heights.get(MAPS::HEIGHT, cur_x, cur_z);
+            float sand = fmax(heights.get(MAPS::SAND, cur_x, cur_z), heights.get(MAPS::CLIFF, cur_x, cur_z));
+            double sandLevel = height - (1.1 - 0.2 * pow(height - 54, 4)) + (5 * sand);
+            tree_column tree = get_tree_column(
+                &randomtree, heights, cur_x, cur_z, treesTile
+            );
 
             for (int cur_y = 0; cur_y < CHUNK_H; cur_y++) {
                 int id = cur_y < SEA_LEVEL ? idWater : BLOCK_AIR;
@@ -170,18 +229,13 @@ void DefaultWorldGenerator::generate(voxel* voxels, int cx, int cz, int seed) {
                     id = idDirt;
                 }
                 else {
-                    int tree = generate_tree(
-                        noise, &randomtree, heights,
-                        cur_x, cur_y, cur_z,
-                        treesTile, idWood, idLeaves);
-                    if (tree) {
-                        id = tree;
+                    int treeBlock = generate_tree(tree, cur_y, idWood, idLeaves);
+                    if (treeBlock) {
+                        id = treeBlock;
                         states = BLOCK_DIR_UP;
                     }
                 }
-                float sand = fmax(heights.get(MAPS::SAND, cur_x, cur_z), heights.get(MAPS::CLIFF, cur_x, cur_z));
-                if (((height - (1.1 - 0.2 * pow(height - 54, 4)) +
-                    (5 * sand)) < cur_y + (height - 0.01 - (int)height))
+                if ((sandLevel < cur_y + (height - 0.01 - (int)height))
                     && (cur_y < height)) {
                     id = idSand;
                 }
@@ -1,18 +1,23 @@
 #ifndef VOXELS_DEFAULTWORLDGENERATOR_H_
 #define VOXELS_DEFAULTWORLDGENERATOR_H_
 
+#include <memory>
 #include "../typedefs.h"
 #include "../voxels/WorldGenerator.h"
 
 struct voxel;
 class Content;
+class ColumnMapsCache;
 
 class DefaultWorldGenerator : WorldGenerator {
+	/// @brief Height and climate maps shared by neighbour chunks
+	std::unique_ptr<ColumnMapsCache> columnMaps;
 public:
 
-	DefaultWorldGenerator(const Content* content) : WorldGenerator(content) {}
+	DefaultWorldGenerator(const Content* content);
+	~DefaultWorldGenerator();
 
-	void generate(voxel* voxels, int x, int z, int seed);
+	void generate(voxel* voxels, generator_context& context) const override;
 };
 
 #endif /* VOXELS_DEFAULTWORLDGENERATOR_H_ */
\ No newline at end of file
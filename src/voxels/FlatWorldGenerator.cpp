@@ -5,7 +5,7 @@
 #include "../content/Content.h"
 #include "../core_defs.h"
 
-void FlatWorldGenerator::generate(voxel* voxels, int cx, int cz, int seed) {
+void FlatWorldGenerator::generate(voxel* voxels, generator_context& context) const {
     for (int z = 0; z < CHUNK_D; z++) {
         for (int x = 0; x < CHUNK_W; x++) {
             for (int cur_y = 0; cur_y < CHUNK_H; cur_y++){
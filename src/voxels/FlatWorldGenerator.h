@@ -12,7 +12,7 @@ public:
 
 	FlatWorldGenerator(const Content* content) : WorldGenerator(content) {}
 
-	void generate(voxel* voxels, int x, int z, int seed);
+	void generate(voxel* voxels, generator_context& context) const override;
 };
 
 #endif /* VOXELS_FLATWORLDGENERATOR_H_ */
\ No newline at end of file
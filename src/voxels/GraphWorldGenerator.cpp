@@ -0,0 +1,594 @@
+#include "GraphWorldGenerator.h"
+#include "voxel.h"
+#include "Chunk.h"
+#include "Block.h"
+
+#include <map>
+#include <tuple>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <numeric>
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "../content/Content.h"
+#include "../data/dynamic.h"
+#include "../files/files.h"
+#include "../maths/PerlinNoise.h"
+
+static constexpr size_t COLUMNS = CHUNK_W * CHUNK_D;
+
+static float fold(graph_op op, float a, float b) {
+    switch (op) {
+        case graph_op::add: return a + b;
+        case graph_op::sub: return a - b;
+        case graph_op::mul: return a * b;
+        case graph_op::div: return a / b;
+        case graph_op::min: return std::min(a, b);
+        case graph_op::max: return std::max(a, b);
+        case graph_op::abs: return std::abs(a);
+        default: return 0.0f;
+    }
+}
+
+/// @return number of operand registers used by the operation
+static int operands_count(graph_op op) {
+    switch (op) {
+        case graph_op::constant:
+        case graph_op::x:
+        case graph_op::z:
+            return 0;
+        case graph_op::abs:
+            return 1;
+        default:
+            return 2;
+    }
+}
+
+static uint32_t float_bits(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static const dynamic::Value* find_value(const dynamic::Map* map, const std::string& key) {
+    auto found = map->values.find(key);
+    if (found == map->values.end()) {
+        return nullptr;
+    }
+    return found->second.get();
+}
+
+static const dynamic::List* find_list(const dynamic::Map* map, const std::string& key) {
+    auto value = find_value(map, key);
+    if (value == nullptr) {
+        return nullptr;
+    }
+    if (value->type != dynamic::valtype::list) {
+        throw std::runtime_error("'"+key+"' must be a list");
+    }
+    return value->value.list;
+}
+
+static const std::unordered_map<std::string, graph_op> OPERATIONS {
+    {"add", graph_op::add},
+    {"sub", graph_op::sub},
+    {"mul", graph_op::mul},
+    {"div", graph_op::div},
+    {"min", graph_op::min},
+    {"max", graph_op::max},
+    {"abs", graph_op::abs},
+};
+
+class graph_compiler {
+    using instruction_key = std::tuple<graph_op, uint, uint, uint32_t, uint, int, uint32_t>;
+
+    generator_graph& graph;
+    /// @brief Named nodes definitions (may be null)
+    const dynamic::Map* nodes;
+    std::unordered_map<std::string, uint> compiledNodes;
+    /// @brief Nodes being compiled, to detect cyclic references
+    std::unordered_set<std::string> visiting;
+    /// @brief Registers of emitted instructions, so equal subexpressions
+    /// are computed once
+    std::map<instruction_key, uint> emitted;
+
+    bool isConstant(uint reg) const {
+        return graph.plan[reg].op == graph_op::constant;
+    }
+
+    bool isConstant(uint reg, float value) const {
+        return isConstant(reg) && graph.plan[reg].value == value;
+    }
+
+    uint emit(graph_instruction instruction) {
+        graph_op op = instruction.op;
+        uint a = instruction.a;
+        uint b = instruction.b;
+        int operands = operands_count(op);
+        if (operands == 1 && isConstant(a)) {
+            return constant(fold(op, graph.plan[a].value, 0.0f));
+        }
+        if (operands == 2 && op != graph_op::noise) {
+            if (isConstant(a) && isConstant(b)) {
+                return constant(fold(op, graph.plan[a].value, graph.plan[b].value));
+            }
+            switch (op) {
+                case graph_op::add:
+                    if (isConstant(a, 0.0f)) return b;
+                    if (isConstant(b, 0.0f)) return a;
+                    break;
+                case graph_op::mul:
+                    if (isConstant(a, 1.0f)) return b;
+                    if (isConstant(b, 1.0f)) return a;
+                    break;
+                case graph_op::sub:
+                    if (isConstant(b, 0.0f)) return a;
+                    break;
+                case graph_op::div:
+                    if (isConstant(b, 1.0f)) return a;
+                    break;
+                default:
+                    break;
+            }
+            // commutative operations operands order does not matter
+            if (op != graph_op::sub && op != graph_op::div && a > b) {
+                std::swap(instruction.a, instruction.b);
+            }
+        }
+        instruction_key key (
+            op, instruction.a, instruction.b,
+            float_bits(instruction.value),
+            instruction.noise, instruction.octaves,
+            float_bits(instruction.persistence)
+        );
+        auto found = emitted.find(key);
+        if (found != emitted.end()) {
+            return found->second;
+        }
+        uint reg = graph.plan.size();
+        graph.plan.push_back(instruction);
+        emitted[key] = reg;
+        return reg;
+    }
+
+    uint constant(float value) {
+        graph_instruction instruction;
+        instruction.op = graph_op::constant;
+        instruction.value = value;
+        return emit(instruction);
+    }
+
+    uint operation(graph_op op, uint a, uint b=0) {
+        graph_instruction instruction;
+        instruction.op = op;
+        instruction.a = a;
+        instruction.b = b;
+        return emit(instruction);
+    }
+
+    uint compileReference(const std::string& name) {
+        if (name == "x") {
+            return operation(graph_op::x, 0);
+        }
+        if (name == "z") {
+            return operation(graph_op::z, 0);
+        }
+        auto found = compiledNodes.find(name);
+        if (found != compiledNodes.end()) {
+            return found->second;
+        }
+        const dynamic::Value* node = nodes ? find_value(nodes, name) : nullptr;
+        if (node == nullptr) {
+            throw std::runtime_error("unknown node '"+name+"'");
+        }
+        if (!visiting.insert(name).second) {
+            throw std::runtime_error("node '"+name+"' references itself");
+        }
+        uint reg;
+        try {
+            reg = compileValue(node);
+        } catch (const std::runtime_error& err) {
+            throw std::runtime_error("node '"+name+"': "+err.what());
+        }
+        visiting.erase(name);
+        compiledNodes[name] = reg;
+        return reg;
+    }
+
+    /// @brief Noise scale or offset: a single expression for both
+    /// coordinates or a list of two ones [x, z]
+    void compileVector(const dynamic::Value* value, uint& x, uint& z) {
+        if (value->type == dynamic::valtype::list) {
+            auto list = value->value.list;
+            if (list->size() != 2) {
+                throw std::runtime_error("list of two expressions [x, z] expected");
+            }
+            x = compileValue(list->get(0));
+            z = compileValue(list->get(1));
+        } else {
+            x = z = compileValue(value);
+        }
+    }
+
+    uint compileNoise(const dynamic::Map* params) {
+        auto xvalue = find_value(params, "x");
+        auto zvalue = find_value(params, "z");
+        uint x = xvalue ? compileValue(xvalue) : compileReference("x");
+        uint z = zvalue ? compileValue(zvalue) : compileReference("z");
+        if (auto scale = find_value(params, "scale")) {
+            uint sx, sz;
+            compileVector(scale, sx, sz);
+            x = operation(graph_op::mul, x, sx);
+            z = operation(graph_op::mul, z, sz);
+        }
+        if (auto offset = find_value(params, "offset")) {
+            uint ox, oz;
+            compileVector(offset, ox, oz);
+            x = operation(graph_op::add, x, ox);
+            z = operation(graph_op::add, z, oz);
+        }
+        int seed = params->getInt("seed", 0);
+        auto& seeds = graph.noiseSeeds;
+        auto found = std::find(seeds.begin(), seeds.end(), seed);
+        if (found == seeds.end()) {
+            found = seeds.insert(seeds.end(), seed);
+        }
+
+        graph_instruction instruction;
+        instruction.op = graph_op::noise;
+        instruction.a = x;
+        instruction.b = z;
+        instruction.noise = found - seeds.begin();
+        instruction.octaves = params->getInt("octaves", 1);
+        instruction.persistence = params->getNum("persistence", 0.5);
+        if (instruction.octaves < 1 || instruction.octaves > 16) {
+            throw std::runtime_error("noise octaves must be in range [1, 16]");
+        }
+        if (instruction.octaves == 1) {
+            instruction.persistence = 0.5f;
+        }
+        return emit(instruction);
+    }
+
+    uint compileOperation(const std::string& name, const dynamic::Value* args) {
+        if (name == "noise") {
+            if (args->type != dynamic::valtype::map) {
+                throw std::runtime_error("noise parameters object expected");
+            }
+            return compileNoise(args->value.map);
+        }
+        auto found = OPERATIONS.find(name);
+        if (found == OPERATIONS.end()) {
+            throw std::runtime_error("unknown operation '"+name+"'");
+        }
+        graph_op op = found->second;
+        if (operands_count(op) == 1) {
+            return operation(op, compileValue(args));
+        }
+        if (args->type != dynamic::valtype::list || args->value.list->size() < 2) {
+            throw std::runtime_error("'"+name+"' takes a list of two or more operands");
+        }
+        auto list = args->value.list;
+        uint reg = compileValue(list->get(0));
+        for (size_t i = 1; i < list->size(); i++) {
+            reg = operation(op, reg, compileValue(list->get(i)));
+        }
+        return reg;
+    }
+
+    template<class F>
+    void forEachOutput(const F& func) {
+        func(graph.height);
+        for (auto& biome : graph.biomes) {
+            if (biome.condition >= 0) {
+                uint reg = biome.condition;
+                func(reg);
+                biome.condition = reg;
+            }
+            for (auto& layer : biome.layers) {
+                func(layer.thickness);
+            }
+        }
+        for (auto& layer : graph.bottomLayers) {
+            func(layer.thickness);
+        }
+    }
+public:
+    graph_compiler(generator_graph& graph, const dynamic::Map* nodes)
+        : graph(graph), nodes(nodes) {
+    }
+
+    /// @brief Keep only instructions and noise seeds contributing
+    /// to the graph outputs
+    void prune() {
+        auto& plan = graph.plan;
+        std::vector<bool> used(plan.size());
+        forEachOutput([&used](uint& reg) {
+            used[reg] = true;
+        });
+        // instructions use registers before them only
+        for (size_t i = plan.size(); i-- > 0;) {
+            if (!used[i]) {
+                continue;
+            }
+            int operands = operands_count(plan[i].op);
+            if (operands > 0) used[plan[i].a] = true;
+            if (operands > 1) used[plan[i].b] = true;
+        }
+
+        std::vector<uint> registers(plan.size());
+        std::vector<int> seeds;
+        std::vector<uint> noises(graph.noiseSeeds.size(), ~0U);
+        size_t count = 0;
+        for (size_t i = 0; i < plan.size(); i++) {
+            if (!used[i]) {
+                continue;
+            }
+            graph_instruction instruction = plan[i];
+            instruction.a = registers[instruction.a];
+            instruction.b = registers[instruction.b];
+            if (instruction.op == graph_op::noise) {
+                uint& noise = noises[instruction.noise];
+                if (noise == ~0U) {
+                    noise = seeds.size();
+                    seeds.push_back(graph.noiseSeeds[instruction.noise]);
+                }
+                instruction.noise = noise;
+            }
+            registers[i] = count;
+            plan[count++] = instruction;
+        }
+        plan.resize(count);
+        graph.noiseSeeds = seeds;
+        forEachOutput([&registers](uint& reg) {
+            reg = registers[reg];
+        });
+    }
+
+    uint compileValue(const dynamic::Value* value) {
+        switch (value->type) {
+            case dynamic::valtype::number:
+                return constant(value->value.decimal);
+            case dynamic::valtype::integer:
+                return constant(value->value.integer);
+            case dynamic::valtype::string:
+                return compileReference(*value->value.str);
+            case dynamic::valtype::map: {
+                auto map = value->value.map;
+                if (map->values.size() != 1) {
+                    throw std::runtime_error("operation object must have a single key");
+                }
+                const auto& entry = *map->values.begin();
+                return compileOperation(entry.first, entry.second.get());
+            }
+            default:
+                throw std::runtime_error("expression expected");
+        }
+    }
+
+    std::vector<graph_layer> compileLayers(const dynamic::List* list) {
+        std::vector<graph_layer> layers;
+        for (size_t i = 0; i < list->size(); i++) {
+            auto map = list->map(i);
+            auto thickness = find_value(map, "thickness");
+            if (thickness == nullptr) {
+                throw std::runtime_error("layer thickness expected");
+            }
+            layers.push_back(graph_layer {
+                map->getStr("block"), compileValue(thickness)
+            });
+        }
+        return layers;
+    }
+};
+
+std::shared_ptr<const generator_graph> GraphWorldGenerator::compile(
+    const dynamic::Map* root
+) {
+    auto graph = std::make_shared<generator_graph>();
+    graph_compiler compiler(*graph, root->map("nodes"));
+
+    auto height = find_value(root, "height");
+    if (height == nullptr) {
+        throw std::runtime_error("height expression expected");
+    }
+    graph->height = compiler.compileValue(height);
+    graph->seaLevel = root->getInt("sea-level", 0);
+    graph->seaBlock = root->getStr("sea-block", "base:water");
+    graph->fillBlock = root->getStr("fill-block", "base:stone");
+
+    if (auto biomes = find_list(root, "biomes")) {
+        for (size_t i = 0; i < biomes->size(); i++) {
+            auto map = biomes->map(i);
+            graph_biome biome {-1, {}};
+            if (auto condition = find_value(map, "condition")) {
+                biome.condition = compiler.compileValue(condition);
+            }
+            if (auto layers = find_list(map, "layers")) {
+                biome.layers = compiler.compileLayers(layers);
+            }
+            graph->biomes.push_back(biome);
+        }
+    }
+    if (graph->biomes.empty()) {
+        graph->biomes.push_back(graph_biome {-1, {}});
+    }
+    if (auto layers = find_list(root, "bottom-layers")) {
+        graph->bottomLayers = compiler.compileLayers(layers);
+    }
+    compiler.prune();
+    return graph;
+}
+
+std::shared_ptr<const generator_graph> GraphWorldGenerator::load(const fs::path& file) {
+    auto root = files::read_json(file);
+    try {
+        return compile(root.get());
+    } catch (const std::runtime_error& err) {
+        throw std::runtime_error(file.u8string()+": "+err.what());
+    }
+}
+
+GraphWorldGenerator::GraphWorldGenerator(
+    const Content* content,
+    std::shared_ptr<const generator_graph> graph
+) : WorldGenerator(content),
+    graph(graph),
+    idSea(content->requireBlock(graph->seaBlock).rt.id),
+    idFill(content->requireBlock(graph->fillBlock).rt.id)
+{
+    for (const auto& biome : graph->biomes) {
+        std::vector<blockid_t> blocks;
+        for (const auto& layer : biome.layers) {
+            blocks.push_back(content->requireBlock(layer.block).rt.id);
+        }
+        biomesBlocks.push_back(blocks);
+    }
+    for (const auto& layer : graph->bottomLayers) {
+        bottomBlocks.push_back(content->requireBlock(layer.block).rt.id);
+    }
+}
+
+/// @brief Shuffled 0..255, the same for the same seeds
+static void make_permutation(int worldSeed, int noiseSeed, int* permutation) {
+    uint32_t hash = uint32_t(worldSeed);
+    hash = (hash ^ uint32_t(noiseSeed)) * 0x9E3779B1;
+    hash ^= hash >> 15;
+    std::minstd_rand random(hash);
+    std::iota(permutation, permutation + 256, 0);
+    for (int i = 255; i > 0; i--) {
+        std::swap(permutation[i], permutation[random() % (i + 1)]);
+    }
+}
+
+template<graph_op op>
+static inline void apply(float* dst, const float* a, const float* b) {
+    for (size_t i = 0; i < COLUMNS; i++) {
+        dst[i] = fold(op, a[i], b[i]);
+    }
+}
+
+/// @return number of blocks given by the value in range [0, CHUNK_H]
+static inline int to_blocks(float value) {
+    // NaN is 0 too
+    return value > 0.0f ? int(std::min(value, float(CHUNK_H))) : 0;
+}
+
+std::shared_ptr<const std::vector<PerlinNoise>> GraphWorldGenerator::getNoises(
+    int seed
+) const {
+    std::lock_guard<std::mutex> lock(noisesMutex);
+    if (noises == nullptr || noisesSeed != seed) {
+        auto created = std::make_shared<std::vector<PerlinNoise>>();
+        created->reserve(graph->noiseSeeds.size());
+        for (int noiseSeed : graph->noiseSeeds) {
+            int permutation[256];
+            make_permutation(seed, noiseSeed, permutation);
+            created->emplace_back(permutation);
+        }
+        noises = std::move(created);
+        noisesSeed = seed;
+    }
+    return noises;
+}
+
+void GraphWorldGenerator::generate(voxel* voxels, generator_context& context) const {
+    const auto& plan = graph->plan;
+    // kept alive if another thread changes the cached seed meanwhile
+    const auto noises = getNoises(context.seed);
+
+    const float zeros[COLUMNS] {};
+    std::unique_ptr<float[]> registers (new float[plan.size() * COLUMNS]);
+    for (size_t reg = 0; reg < plan.size(); reg++) {
+        const auto& instruction = plan[reg];
+        float* dst = registers.get() + reg * COLUMNS;
+        const float* a = registers.get() + instruction.a * COLUMNS;
+        const float* b = registers.get() + instruction.b * COLUMNS;
+        switch (instruction.op) {
+            case graph_op::constant:
+                std::fill_n(dst, COLUMNS, instruction.value);
+                break;
+            case graph_op::x:
+                for (size_t i = 0; i < COLUMNS; i++) {
+                    dst[i] = context.cx * CHUNK_W + int(i % CHUNK_W);
+                }
+                break;
+            case graph_op::z:
+                for (size_t i = 0; i < COLUMNS; i++) {
+                    dst[i] = context.cz * CHUNK_D + int(i / CHUNK_W);
+                }
+                break;
+            case graph_op::add: apply<graph_op::add>(dst, a, b); break;
+            case graph_op::sub: apply<graph_op::sub>(dst, a, b); break;
+            case graph_op::mul: apply<graph_op::mul>(dst, a, b); break;
+            case graph_op::div: apply<graph_op::div>(dst, a, b); break;
+            case graph_op::min: apply<graph_op::min>(dst, a, b); break;
+            case graph_op::max: apply<graph_op::max>(dst, a, b); break;
+            case graph_op::abs: apply<graph_op::abs>(dst, a, a); break;
+            case graph_op::noise: {
+                const auto& noise = (*noises)[instruction.noise];
+                if (instruction.octaves == 1) {
+                    noise.noise(a, zeros, b, dst, COLUMNS);
+                } else {
+                    noise.fbm(
+                        a, zeros, b, dst, COLUMNS,
+                        instruction.octaves, instruction.persistence
+                    );
+                }
+                break;
+            }
+        }
+    }
+    auto values = [&registers](uint reg) {
+        return registers.get() + reg * COLUMNS;
+    };
+
+    const auto& biomes = graph->biomes;
+    const float* heights = values(graph->height);
+    const int seaLevel = graph->seaLevel;
+    for (int z = 0; z < CHUNK_D; z++) {
+        for (int x = 0; x < CHUNK_W; x++) {
+            const size_t column = z * CHUNK_W + x;
+            auto fill = [=](int fromY, int toY, blockid_t id) {
+                fromY = std::max(fromY, 0);
+                toY = std::min(toY, CHUNK_H);
+                for (int y = fromY; y < toY; y++) {
+                    voxel& vox = voxels[(y * CHUNK_D + z) * CHUNK_W + x];
+                    vox.id = id;
+                    vox.states = 0;
+                }
+            };
+            const int top = to_blocks(heights[column]);
+            fill(0, top, idFill);
+            fill(top, seaLevel, idSea);
+            fill(std::max(top, seaLevel), CHUNK_H, idAir);
+
+            // the last biome is used where no conditions are met
+            size_t index = 0;
+            for (; index + 1 < biomes.size(); index++) {
+                int condition = biomes[index].condition;
+                if (condition < 0 || values(condition)[column] > 0.0f) {
+                    break;
+                }
+            }
+            const auto& layers = biomes[index].layers;
+            int y = top;
+            for (size_t i = 0; i < layers.size(); i++) {
+                int thickness = to_blocks(values(layers[i].thickness)[column]);
+                fill(y - thickness, y, biomesBlocks[index][i]);
+                y -= thickness;
+            }
+            y = 0;
+            for (size_t i = 0; i < bottomBlocks.size(); i++) {
+                const auto& layer = graph->bottomLayers[i];
+                int thickness = to_blocks(values(layer.thickness)[column]);
+                fill(y, y + thickness, bottomBlocks[i]);
+                y += thickness;
+            }
+        }
+    }
+}
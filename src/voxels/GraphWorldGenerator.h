@@ -0,0 +1,112 @@
+#ifndef VOXELS_GRAPH_WORLD_GENERATOR_H_
+#define VOXELS_GRAPH_WORLD_GENERATOR_H_
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <filesystem>
+
+#include "../typedefs.h"
+#include "../voxels/WorldGenerator.h"
+#include "../maths/PerlinNoise.h"
+
+namespace fs = std::filesystem;
+
+namespace dynamic {
+    class Map;
+}
+
+struct voxel;
+class Content;
+
+enum class graph_op : ubyte {
+    constant, x, z, add, sub, mul, div, min, max, abs, noise
+};
+
+/// @brief Instruction of a compiled generator graph. Every instruction
+/// computes one register: its value for all columns of the chunk
+struct graph_instruction {
+    graph_op op;
+    /// @brief Operand registers (noise: x and z coordinates)
+    uint a = 0;
+    uint b = 0;
+    /// @brief Value of constant
+    float value = 0.0f;
+    /// @brief Index of the noise seed in generator_graph::noiseSeeds
+    uint noise = 0;
+    int octaves = 1;
+    float persistence = 0.5f;
+};
+
+struct graph_layer {
+    std::string block;
+    /// @brief Register of the layer thickness (blocks)
+    uint thickness;
+};
+
+struct graph_biome {
+    /// @brief Register of the condition (biome is chosen where it's
+    /// greater than zero) or -1 for the biome used everywhere
+    int condition;
+    /// @brief Surface layers, the top one first
+    std::vector<graph_layer> layers;
+};
+
+/// @brief Generator definition compiled to a plan of instructions
+/// evaluated for all columns of a chunk at once
+struct generator_graph {
+    /// @brief Instructions in evaluation order, the i-th one computes
+    /// register i from registers before it
+    std::vector<graph_instruction> plan;
+    /// @brief Seeds of noise permutations (mixed with the world seed)
+    std::vector<int> noiseSeeds;
+    /// @brief Register of the terrain height
+    uint height;
+    std::vector<graph_biome> biomes;
+    /// @brief Layers on the bottom of the world, the lowest one first
+    std::vector<graph_layer> bottomLayers;
+    int seaLevel;
+    std::string seaBlock;
+    std::string fillBlock;
+};
+
+/// @brief Generator defined by a content pack json file
+/// (see doc/en/2.Content-packs.md)
+class GraphWorldGenerator : WorldGenerator {
+    std::shared_ptr<const generator_graph> graph;
+    /// @brief Block ids of graph->biomes layers
+    std::vector<std::vector<blockid_t>> biomesBlocks;
+    std::vector<blockid_t> bottomBlocks;
+    blockid_t idSea;
+    blockid_t idFill;
+
+    /// @brief Noises of graph->noiseSeeds for the world seed last used
+    /// (cache, the seed rarely changes)
+    mutable std::shared_ptr<const std::vector<PerlinNoise>> noises;
+    mutable int noisesSeed = 0;
+    mutable std::mutex noisesMutex;
+
+    /// @brief Get noises of the world seed (thread-safe)
+    std::shared_ptr<const std::vector<PerlinNoise>> getNoises(int seed) const;
+public:
+    /// @throws std::runtime_error if a block used is not found
+    GraphWorldGenerator(
+        const Content* content,
+        std::shared_ptr<const generator_graph> graph
+    );
+
+    void generate(voxel* voxels, generator_context& context) const override;
+
+    /// @brief Compile generator definition. Named nodes not used are
+    /// skipped, constant expressions are folded and equal subexpressions
+    /// are computed once
+    /// @throws std::runtime_error if the definition is invalid
+    static std::shared_ptr<const generator_graph> compile(const dynamic::Map* root);
+
+    /// @brief Read and compile generator definition json file
+    /// @throws std::runtime_error if the file could not be read or is invalid
+    static std::shared_ptr<const generator_graph> load(const fs::path& file);
+};
+
+#endif // VOXELS_GRAPH_WORLD_GENERATOR_H_
@@ -3,16 +3,18 @@
 
 #include "../typedefs.h"
 #include "../voxels/WorldGenerator.h"
+#include "../maths/PerlinNoise.h"
 
 struct voxel;
 class Content;
 
 class SpaceWorldGenerator : WorldGenerator {
+	const PerlinNoise noise;
 public:
 
 	SpaceWorldGenerator(const Content* content) : WorldGenerator(content) {}
 
-	void generate(voxel* voxels, int x, int z, int seed);
+	void generate(voxel* voxels, generator_context& context) const override;
 };
 
 #endif /* VOXELS_SPACEWORLDGENERATOR_H_ */
\ No newline at end of file
@@ -5,6 +5,16 @@
 
 #include "../content/Content.h"
 
+generator_context::generator_context(int cx, int cz, int seed)
+	: cx(cx), cz(cz), seed(seed) {
+	// neighbour chunks and close seeds must not get close random seeds
+	uint32_t hash = uint32_t(seed);
+	hash = (hash ^ uint32_t(cx)) * 0x9E3779B1;
+	hash = (hash ^ (hash >> 15) ^ uint32_t(cz)) * 0x85EBCA77;
+	hash ^= hash >> 13;
+	random.seed(hash);
+}
+
 WorldGenerator::WorldGenerator(const Content* content)
                : idStone(content->requireBlock("base:stone").rt.id),
                  idDirt(content->requireBlock("base:dirt").rt.id),
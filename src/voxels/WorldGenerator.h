@@ -3,10 +3,25 @@
 
 #include "../typedefs.h"
 #include <string>
+#include <random>
 
 struct voxel;
 class Content;
 
+/// @brief State of a single chunk generation call
+struct generator_context {
+	const int cx;
+	const int cz;
+	const int seed;
+	/// @brief Random numbers seeded from (seed, cx, cz), so the chunk
+	/// is the same whatever thread or order it's generated in
+	std::minstd_rand random;
+
+	generator_context(int cx, int cz, int seed);
+};
+
+/// @brief Chunk voxels generator. Generators keep no state changed by
+/// generate, so one instance may be used by multiple threads at once
 class WorldGenerator {
 protected:
 	blockid_t const idStone;
@@ -34,7 +49,8 @@ public:
 	WorldGenerator(const Content* content);
     virtual ~WorldGenerator() = default;
 
-	virtual void generate(voxel* voxels, int x, int z, int seed) = 0;
+	/// @param voxels CHUNK_VOL voxels to fill
+	virtual void generate(voxel* voxels, generator_context& context) const = 0;
 };
 
 #endif /* VOXELS_WORLDGENERATOR_H_ */
\ No newline at end of file
@@ -0,0 +1,83 @@
+#ifndef VOXELS_TERRAIN_COLUMNS_H_
+#define VOXELS_TERRAIN_COLUMNS_H_
+
+#include <cstdlib>
+#include <math.h>
+#include <cmath>
+#include <stddef.h>
+
+#include "../constants.h"
+
+/// @brief Terrain of the chunk columns used by the debris, space
+/// and tropical generators, indexed [z * CHUNK_W + x]
+struct terrain_columns {
+    static constexpr int COLUMNS = CHUNK_W * CHUNK_D;
+    float height[COLUMNS];
+    float sand[COLUMNS];
+    float cliff[COLUMNS];
+};
+
+/// @brief Compute terrain of all columns of the chunk. Noise of all the
+/// columns is evaluated at once
+/// @param sample noise batch call sample(dst, count, coords) taking
+/// the same arguments as PerlinNoise::sample
+template<class F>
+void compute_terrain_columns(
+    terrain_columns& columns, int cx, int cz, int seaLevel, const F& sample
+) {
+    constexpr int COLUMNS = terrain_columns::COLUMNS;
+    // fx, fz get the noise coords from the column world coords
+    auto sampleMap = [&sample, cx, cz](float* dst, auto fx, auto fz) {
+        sample(dst, COLUMNS, [=](size_t i, float& x, float& y, float& z) {
+            x = fx((float)(int(i % CHUNK_W) + cx * CHUNK_W));
+            y = 0;
+            z = fz((float)(int(i / CHUNK_W) + cz * CHUNK_D));
+        });
+    };
+    float octave1[COLUMNS], octave2[COLUMNS], octave3[COLUMNS], octave4[COLUMNS];
+    float warpX[COLUMNS], warpZ[COLUMNS], warped[COLUMNS], warpScale[COLUMNS];
+    float scale[COLUMNS];
+    float* sands = columns.sand;
+    sampleMap(octave1, [](float x) { return x * 0.0125f * 8 - 125567; }, [](float z) { return z * 0.0125f * 8 + 3546; });
+    sampleMap(octave2, [](float x) { return x * 0.025f * 8 + 4647; }, [](float z) { return z * 0.025f * 8 - 3436; });
+    sampleMap(octave3, [](float x) { return x * 0.05f * 8 - 834176; }, [](float z) { return z * 0.05f * 8 + 23678; });
+    sampleMap(warpX, [](float x) { return x * 0.1f * 8 - 23557; }, [](float z) { return z * 0.1f * 8 - 6568; });
+    sampleMap(warpZ, [](float x) { return x * 0.1f * 8 + 4363; }, [](float z) { return z * 0.1f * 8 + 4456; });
+    sample(warped, COLUMNS, [&](size_t i, float& x, float& y, float& z) {
+        x = (float)(int(i % CHUNK_W) + cx * CHUNK_W) * 0.2f * 8 + warpX[i] * 50;
+        y = 0;
+        z = (float)(int(i / CHUNK_W) + cz * CHUNK_D) * 0.2f * 8 + warpZ[i] * 50;
+    });
+    sampleMap(warpScale, [](float x) { return x * 0.01f - 834176; }, [](float z) { return z * 0.01f + 23678; });
+    sampleMap(octave4, [](float x) { return x * 0.1f * 8 - 3465; }, [](float z) { return z * 0.1f * 8 + 4534; });
+    sampleMap(scale, [](float x) { return x * 0.1f + 1000; }, [](float z) { return z * 0.1f + 1000; });
+    sampleMap(sands, [](float x) { return x * 0.1f - 633; }, [](float z) { return z * 0.1f + 1000; });
+
+    for (int i = 0; i < COLUMNS; i++) {
+        float height = octave1[i];
+        height += octave2[i] * 0.5f;
+        height += octave3[i] * 0.25f;
+        height += warped[i] * warpScale[i] * 0.25;
+        height += octave4[i] * 0.125f;
+        height *= scale[i] * 0.5f + 0.5f;
+        height += 1.0f;
+        height *= 64.0f;
+
+        float sand = sands[i];
+        float cliff = pow((sand + abs(sand)) / 2, 1);
+        float w = pow(fmax(-abs(height - seaLevel) + 4, 0) / 6, 2) * cliff;
+        float h1 = -abs(height - seaLevel - 0.03);
+        float h2 = abs(height - seaLevel + 0.04);
+        float h = (h1 + h2) * 100;
+
+        if (sand > 0.7f) {
+            h *= 2.0f;
+        }
+
+        height += (h * w - 2 * h * w + 2);
+        columns.height[i] = height;
+        columns.cliff[i] = cliff;
+    }
+}
+
+#endif // VOXELS_TERRAIN_COLUMNS_H_
@@ -26,6 +26,10 @@ struct voxel {
     inline void setRotation(uint8_t rotation) {
         states = (states & (~BLOCK_ROT_MASK)) | (rotation & BLOCK_ROT_MASK);
     }
+
+    inline bool operator==(const voxel& other) const {
+        return id == other.id && states == other.states;
+    }
 };
 
 #endif /* VOXELS_VOXEL_H_ */
@@ -31,6 +31,12 @@ Level::Level(World* world, const Content* content, EngineSettings& settings)
 
 	events->listen(EVT_CHUNK_HIDDEN, [this](lvl_event_type type, Chunk* chunk) {
 		this->chunksStorage->remove(chunk->x, chunk->z);
+		this->lighting->onChunkUnloaded(chunk);
+	});
+	// queued light updates refer to chunks by matrix places, which
+	// change when the matrix is resized
+	events->listen(EVT_CHUNKS_MOVE, [this](lvl_event_type type, Chunk*) {
+		this->lighting->flush();
 	});
 
 	inventories = std::make_unique<Inventories>(*this);
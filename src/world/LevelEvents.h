@@ -9,6 +9,10 @@ class Chunk;
 
 enum lvl_event_type {
 	EVT_CHUNK_HIDDEN,
+	/// @brief Chunks matrix is about to be resized or cleared, so chunks
+	/// change their places (chunk is nullptr). Not triggered when the
+	/// matrix is translated: chunks staying keep their places
+	EVT_CHUNKS_MOVE,
 };
 
 typedef std::function<void(lvl_event_type, Chunk*)> chunk_event_func;
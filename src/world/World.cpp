@@ -52,18 +52,26 @@ void World::write(Level* level) {
 
     Chunks* chunks = level->chunks.get();
 
+    std::vector<Chunk*> written;
     for (size_t i = 0; i < chunks->volume; i++) {
         auto chunk = chunks->chunks[i];
         if (chunk == nullptr || !chunk->isLighted())
             continue;
-        bool lightsUnsaved = !chunk->isLoadedLights() && 
+        bool lightsCached = settings.debug.doWriteFullLights ?
+                            chunk->isLoadedFullLights() :
+                            chunk->isLoadedLights();
+        bool lightsUnsaved = (!lightsCached || chunk->isUnsavedLights()) && 
                               settings.debug.doWriteLights;
         if (!chunk->isUnsaved() && !lightsUnsaved)
             continue;
         wfile->put(chunk.get());
+        written.push_back(chunk.get());
     }
 
     wfile->write(this, content);
+    for (Chunk* chunk : written) {
+        chunk->setUnsavedLights(false);
+    }
 	auto playerFile = dynamic::Map();
     {
         auto& players = playerFile.putList("players");
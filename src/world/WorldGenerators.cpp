@@ -1,14 +1,62 @@
 #include "WorldGenerators.h"
 #include "../voxels/WorldGenerator.h"
+#include "../voxels/DefaultWorldGenerator.h"
 #include "../voxels/DebrisWorldGenerator.h"
 #include "../voxels/CubicWorldGenerator.h"
 #include "../voxels/FlatWorldGenerator.h"
 #include "../voxels/SpaceWorldGenerator.h"
+#include "../voxels/TropicalWorldGenerator.h"
+#include "../voxels/GraphWorldGenerator.h"
 #include "../content/Content.h"
+#include "../content/ContentPack.h"
+#include "../files/engine_paths.h"
 #include <vector>
 #include <map>
 #include <string>
 #include <iostream>
+#include <stdexcept>
+
+void WorldGenerators::addGenerator(std::string id, gen_constructor constructor) {
+    generators[id] = constructor;
+}
+
+static void addPackGenerators(EnginePaths* paths) {
+    std::vector<ContentPack> packs;
+    ContentPack::scanFolder(paths->getResources()/fs::path("content"), packs);
+    ContentPack::scanFolder(paths->getUserfiles()/fs::path("content"), packs);
+    for (const auto& pack : packs) {
+        fs::path folder = pack.folder/ContentPack::GENERATORS_FOLDER;
+        if (!fs::is_directory(folder)) {
+            continue;
+        }
+        for (const auto& entry : fs::directory_iterator(folder)) {
+            fs::path file = entry.path();
+            if (!fs::is_regular_file(file) || file.extension() != ".json") {
+                continue;
+            }
+            std::string id = pack.id+":"+file.stem().u8string();
+            try {
+                auto graph = GraphWorldGenerator::load(file);
+                WorldGenerators::addGenerator(id, [graph](const Content* content) {
+                    return (WorldGenerator*) new GraphWorldGenerator(content, graph);
+                });
+            } catch (const std::runtime_error& err) {
+                std::cerr << "could not to load generator " << id << ": ";
+                std::cerr << err.what() << std::endl;
+            }
+        }
+    }
+}
+
+void WorldGenerators::addDefaultGenerators(EnginePaths* paths) {
+    addGenerator<DefaultWorldGenerator>("core:default");
+    addGenerator<FlatWorldGenerator>("core:flat");
+    addGenerator<DebrisWorldGenerator>("core:debris");
+    addGenerator<CubicWorldGenerator>("core:cubic");
+    addGenerator<SpaceWorldGenerator>("core:space");
+//    addGenerator<TropicalWorldGenerator>("core:tropical");
+    addPackGenerators(paths);
+}
 
 std::vector<std::string> WorldGenerators::getGeneratorsIDs() {
     std::vector<std::string> ids;
@@ -25,6 +73,14 @@ std::string WorldGenerators::getDefaultGeneratorID() {
 }
 
 WorldGenerator* WorldGenerators::createGenerator(std::string id, const Content* content) {
+    // generators of all packs found are registered, but only ones of
+    // the world content packs may be used
+    std::string pack = id.substr(0, id.find(':'));
+    if (pack != "core" && content->getPackRuntime(pack) == nullptr) {
+        throw std::runtime_error(
+            "generator "+id+" requires content pack '"+pack+"'"
+        );
+    }
     for(std::map<std::string, gen_constructor>::iterator it = generators.begin(); it != generators.end(); ++it) {
         if(id == it->first) {
             return (WorldGenerator*) it->second(content);
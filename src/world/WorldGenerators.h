@@ -6,8 +6,11 @@
 #include <map>
 #include <vector>
 #include <string>
+#include <functional>
 
-typedef WorldGenerator* (*gen_constructor) (const Content*);
+typedef std::function<WorldGenerator* (const Content*)> gen_constructor;
+
+class EnginePaths;
 
 
 class WorldGenerators {
@@ -17,10 +20,21 @@ public:
     template <typename T>
     static void addGenerator(std::string id);
 
+    /// @brief Register generator created by the function
+    /// (used for generators defined by content packs)
+    static void addGenerator(std::string id, gen_constructor constructor);
+
+    /// @brief Register core generators and generators defined in the
+    /// generators folders of all content packs found (as "pack:file name")
+    static void addDefaultGenerators(EnginePaths* paths);
+
     static std::vector<std::string> getGeneratorsIDs();
 
     static std::string getDefaultGeneratorID();
 
+    /// @return generator or nullptr if id is unknown
+    /// @throws std::runtime_error if the generator pack is not 
+    /// in the content
     static WorldGenerator* createGenerator(std::string id, const Content* content);
 };
 
@@ -0,0 +1,75 @@
+#ifndef TEST_FIXTURE_H_
+#define TEST_FIXTURE_H_
+
+// Helpers shared by tests and benchmarks: content built in memory
+// (no content packs scripts or assets are loaded) and data hashing
+
+#include "content/Content.h"
+#include "content/ContentPack.h"
+#include "core_defs.h"
+#include "logic/scripting/scripting.h"
+#include "voxels/Block.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace fixture {
+    /// @brief FNV-1a hash parameters
+    inline constexpr uint64_t HASH_OFFSET = 14695981039346656037ull;
+    inline constexpr uint64_t HASH_PRIME = 1099511628211ull;
+
+    inline void hash_combine(uint64_t& hash, uint64_t value) {
+        hash ^= value;
+        hash *= HASH_PRIME;
+    }
+
+    /// @brief Create block having no item (items are not defined)
+    inline Block& create_block(ContentBuilder& builder, const std::string& id) {
+        Block& block = builder.createBlock(id);
+        block.pickingItem = CORE_EMPTY;
+        return block;
+    }
+
+    /// @brief Add runtime of the content pack read from the folder
+    /// (with no scripting environment)
+    inline void add_pack(ContentBuilder& builder, const fs::path& folder) {
+        builder.add(new ContentPackRuntime(ContentPack::read(folder), nullptr));
+    }
+
+    /// @brief Build content of the core blocks and ones added by
+    /// setup(builder)
+    template<class F>
+    Content* build_content(const F& setup) {
+        ContentBuilder builder;
+        corecontent::setup(&builder);
+        setup(builder);
+        return builder.build();
+    }
+
+    /// @brief Blocks used by the core world generators
+    inline const std::vector<std::string> GENERATOR_BLOCKS {
+        "base:stone", "base:dirt", "base:grass_block", "base:sand", "base:water",
+        "base:wood", "base:leaves", "base:grass", "base:flower", "base:bazalt",
+        "base:debris", "base:moss", "base:brick", "base:brick_debris", "base:rust"
+    };
+
+    /// @brief Build content of the blocks used by the core world generators
+    /// and runtimes of the content packs found in the resources folder
+    /// (generators of a pack require its runtime)
+    inline Content* build_generators_content(const fs::path& resources) {
+        std::vector<ContentPack> packs;
+        ContentPack::scanFolder(resources/fs::path("content"), packs);
+        return build_content([&packs](ContentBuilder& builder) {
+            for (const auto& name : GENERATOR_BLOCKS) {
+                create_block(builder, name);
+            }
+            for (const auto& pack : packs) {
+                add_pack(builder, pack.folder);
+            }
+        });
+    }
+}
+
+#endif // TEST_FIXTURE_H_
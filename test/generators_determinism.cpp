@@ -0,0 +1,96 @@
+// World generators determinism test: generates a fixed area with one
+// thread and with multiple threads sharing the generator, then compares
+// hashes of the chunks. All generators the engine registers are checked,
+// including ones defined by the content packs in res/content.
+// Built with -DVOXELENGINE_BUILD_TESTS=ON, runs where res/ is (ctest runs
+// it in the build directory res/ is copied to)
+#include "fixture.h"
+#include "constants.h"
+#include "files/engine_paths.h"
+#include "voxels/voxel.h"
+#include "voxels/WorldGenerator.h"
+#include "world/WorldGenerators.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <stdexcept>
+
+/// @brief Area generated is AREA_SIZE x AREA_SIZE chunks around (0, 0)
+inline constexpr int AREA_SIZE = 6;
+inline constexpr int AREA_CHUNKS = AREA_SIZE * AREA_SIZE;
+inline constexpr int THREADS = 4;
+inline constexpr int SEED = 42;
+
+static uint64_t hash_chunk(const voxel* voxels) {
+    uint64_t hash = fixture::HASH_OFFSET;
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        fixture::hash_combine(hash, voxels[i].id | (uint64_t(voxels[i].states) << 16));
+    }
+    return hash;
+}
+
+/// @brief Generate the area by threads sharing the generator
+/// @param reversed generate chunks in reversed order
+/// @return hashes of the area chunks
+static std::vector<uint64_t> generate_area(
+    const WorldGenerator& generator, int threadsCount, bool reversed
+) {
+    std::vector<uint64_t> hashes(AREA_CHUNKS);
+    std::atomic<int> next = 0;
+    auto worker = [&]() {
+        auto voxels = std::make_unique<voxel[]>(CHUNK_VOL);
+        for (int i; (i = next++) < AREA_CHUNKS;) {
+            int index = reversed ? AREA_CHUNKS - 1 - i : i;
+            int cx = index % AREA_SIZE - AREA_SIZE / 2;
+            int cz = index / AREA_SIZE - AREA_SIZE / 2;
+            generator_context context(cx, cz, SEED);
+            generator.generate(voxels.get(), context);
+            hashes[index] = hash_chunk(voxels.get());
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threadsCount; i++) {
+        threads.emplace_back(worker);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    return hashes;
+}
+
+int main() {
+    EnginePaths paths;
+    paths.setResources("res");
+    WorldGenerators::addDefaultGenerators(&paths);
+
+    std::unique_ptr<Content> content (
+        fixture::build_generators_content(paths.getResources())
+    );
+    int failed = 0;
+    for (const auto& id : WorldGenerators::getGeneratorsIDs()) {
+        std::unique_ptr<WorldGenerator> generator;
+        try {
+            generator.reset(WorldGenerators::createGenerator(id, content.get()));
+        } catch (const std::runtime_error& err) {
+            std::cout << id << ": " << err.what() << std::endl;
+        }
+        if (generator == nullptr) {
+            failed++;
+            continue;
+        }
+        auto expected = generate_area(*generator, 1, false);
+        auto reversed = generate_area(*generator, 1, true);
+        auto threaded = generate_area(*generator, THREADS, false);
+
+        bool passed = expected == reversed && expected == threaded;
+        std::cout << id << ": " << (passed ? "ok" : "FAILED") << std::endl;
+        if (!passed) {
+            failed++;
+        }
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,444 @@
+// Lighting differential test: lights random scenes with the engine
+// lighting (all channels solved at once) and with the reference solver
+// running each channel separately (the original LightSolver), then
+// edits random blocks and compares the lightmaps every CHECK_EDITS edits.
+// Built with -DVOXELENGINE_BUILD_TESTS=ON
+#include "fixture.h"
+#include "lighting/Lighting.h"
+#include "lighting/Lightmap.h"
+#include "voxels/Chunk.h"
+#include "voxels/Chunks.h"
+#include "world/LevelEvents.h"
+
+#include <cmath>
+#include <queue>
+#include <memory>
+#include <random>
+#include <iterator>
+#include <iostream>
+
+/// @brief Chunks matrix size, the outer ring is not lit
+inline constexpr int AREA_SIZE = 7;
+inline constexpr int SCENES = 4;
+inline constexpr int EDITS = 400;
+inline constexpr int CHECK_EDITS = 20;
+
+namespace reference {
+    struct light_entry {
+        int x;
+        int y;
+        int z;
+        ubyte light;
+    };
+
+    /// @brief Single channel light solver
+    class LightSolver {
+        std::queue<light_entry> addqueue;
+        std::queue<light_entry> remqueue;
+        const ContentIndices* const indices;
+        Chunks& chunks;
+        int channel;
+    public:
+        LightSolver(const ContentIndices* indices, Chunks& chunks, int channel)
+        : indices(indices), chunks(chunks), channel(channel) {}
+
+        void add(int x, int y, int z, int emission) {
+            if (emission <= 1) {
+                return;
+            }
+            Chunk* chunk = chunks.getChunkByVoxel(x, y, z);
+            if (chunk == nullptr) {
+                return;
+            }
+            addqueue.push(light_entry {x, y, z, ubyte(emission)});
+            chunk->lightmap.set(
+                x - chunk->x * CHUNK_W, y, z - chunk->z * CHUNK_D,
+                channel, emission
+            );
+        }
+
+        void add(int x, int y, int z) {
+            add(x, y, z, chunks.getLight(x, y, z, channel));
+        }
+
+        void remove(int x, int y, int z) {
+            Chunk* chunk = chunks.getChunkByVoxel(x, y, z);
+            if (chunk == nullptr) {
+                return;
+            }
+            int lx = x - chunk->x * CHUNK_W;
+            int lz = z - chunk->z * CHUNK_D;
+            ubyte light = chunk->lightmap.get(lx, y, lz, channel);
+            if (light == 0) {
+                return;
+            }
+            remqueue.push(light_entry {x, y, z, light});
+            chunk->lightmap.set(lx, y, lz, channel, 0);
+        }
+
+        void solve() {
+            static const int offsets[6][3] {
+                {0, 0, 1}, {0, 0, -1}, {0, 1, 0}, {0, -1, 0}, {1, 0, 0}, {-1, 0, 0}
+            };
+            while (!remqueue.empty()) {
+                const light_entry entry = remqueue.front();
+                remqueue.pop();
+                for (const auto& offset : offsets) {
+                    int x = entry.x + offset[0];
+                    int y = entry.y + offset[1];
+                    int z = entry.z + offset[2];
+                    Chunk* chunk = chunks.getChunkByVoxel(x, y, z);
+                    if (chunk == nullptr) {
+                        continue;
+                    }
+                    int lx = x - chunk->x * CHUNK_W;
+                    int lz = z - chunk->z * CHUNK_D;
+                    ubyte light = chunk->lightmap.get(lx, y, lz, channel);
+                    if (light != 0 && light == entry.light - 1) {
+                        remqueue.push(light_entry {x, y, z, light});
+                        chunk->lightmap.set(lx, y, lz, channel, 0);
+                    } else if (light >= entry.light) {
+                        addqueue.push(light_entry {x, y, z, light});
+                    }
+                }
+            }
+            const ubyte* lightPassing = indices->getBlockProps().lightPassing.data();
+            while (!addqueue.empty()) {
+                const light_entry entry = addqueue.front();
+                addqueue.pop();
+                for (const auto& offset : offsets) {
+                    int x = entry.x + offset[0];
+                    int y = entry.y + offset[1];
+                    int z = entry.z + offset[2];
+                    Chunk* chunk = chunks.getChunkByVoxel(x, y, z);
+                    if (chunk == nullptr) {
+                        continue;
+                    }
+                    int lx = x - chunk->x * CHUNK_W;
+                    int lz = z - chunk->z * CHUNK_D;
+                    ubyte light = chunk->lightmap.get(lx, y, lz, channel);
+                    const voxel& vox = chunk->voxels[vox_index(lx, y, lz)];
+                    if (lightPassing[vox.id] && light + 2 <= entry.light) {
+                        chunk->lightmap.set(lx, y, lz, channel, entry.light - 1);
+                        addqueue.push(light_entry {x, y, z, ubyte(entry.light - 1)});
+                    }
+                }
+            }
+        }
+    };
+
+    /// @brief Lighting of the chunks made of one solver per channel
+    class Lighting {
+        const ContentIndices* const indices;
+        Chunks& chunks;
+        std::unique_ptr<LightSolver> solvers[4];
+    public:
+        Lighting(const ContentIndices* indices, Chunks& chunks)
+        : indices(indices), chunks(chunks) {
+            for (int channel = 0; channel < 4; channel++) {
+                solvers[channel] = std::make_unique<LightSolver>(
+                    indices, chunks, channel
+                );
+            }
+        }
+
+        void solve() {
+            for (auto& solver : solvers) {
+                solver->solve();
+            }
+        }
+
+        void buildSkyLight(int cx, int cz) {
+            const ubyte* lightPassing = indices->getBlockProps().lightPassing.data();
+            LightSolver& solverS = *solvers[3];
+            Chunk* chunk = chunks.getChunk(cx, cz);
+            for (int z = 0; z < CHUNK_D; z++) {
+                for (int x = 0; x < CHUNK_W; x++) {
+                    int gx = x + cx * CHUNK_W;
+                    int gz = z + cz * CHUNK_D;
+                    for (int y = chunk->lightmap.highestPoint; y >= 0; y--) {
+                        while (y > 0 && !lightPassing[chunk->voxels[vox_index(x, y, z)].id]) {
+                            y--;
+                        }
+                        if (chunk->lightmap.getS(x, y, z) != 15) {
+                            solverS.add(gx, y + 1, gz);
+                            for (; y >= 0; y--) {
+                                solverS.add(gx + 1, y, gz);
+                                solverS.add(gx - 1, y, gz);
+                                solverS.add(gx, y, gz + 1);
+                                solverS.add(gx, y, gz - 1);
+                            }
+                        }
+                    }
+                }
+            }
+            solverS.solve();
+        }
+
+        void onChunkLoaded(int cx, int cz) {
+            auto blockDefs = indices->getBlockDefs();
+            const Chunk* chunk = chunks.getChunk(cx, cz);
+            for (int y = 0; y < CHUNK_H; y++) {
+                for (int z = 0; z < CHUNK_D; z++) {
+                    for (int x = 0; x < CHUNK_W; x++) {
+                        const Block* block = blockDefs[chunk->voxels[vox_index(x, y, z)].id];
+                        for (int channel = 0; channel < 3; channel++) {
+                            solvers[channel]->add(
+                                x + cx * CHUNK_W, y, z + cz * CHUNK_D,
+                                block->emission[channel]
+                            );
+                        }
+                    }
+                }
+            }
+            // chunk border lights spread to the chunk
+            for (int y = 0; y < CHUNK_H; y++) {
+                for (int z = 0; z < CHUNK_D; z++) {
+                    for (int x = 0; x < CHUNK_W; x++) {
+                        if (x != 0 && x != CHUNK_W - 1 &&
+                            z != 0 && z != CHUNK_D - 1) {
+                            continue;
+                        }
+                        light_t light = chunk->lightmap.get(x, y, z);
+                        for (int channel = 0; channel < 4; channel++) {
+                            solvers[channel]->add(
+                                x + cx * CHUNK_W, y, z + cz * CHUNK_D,
+                                Lightmap::extract(light, channel)
+                            );
+                        }
+                    }
+                }
+            }
+            solve();
+        }
+
+        void onBlockSet(int x, int y, int z, blockid_t id) {
+            const Block* block = indices->getBlockDef(id);
+            LightSolver& solverS = *solvers[3];
+            for (int channel = 0; channel < 3; channel++) {
+                solvers[channel]->remove(x, y, z);
+            }
+            if (id == 0) {
+                solve();
+                if (chunks.getLight(x, y + 1, z, 3) == 0xF) {
+                    for (int i = y; i >= 0; i--) {
+                        const voxel* vox = chunks.get(x, i, z);
+                        if (vox == nullptr || vox->id != 0) {
+                            break;
+                        }
+                        solverS.add(x, i, z, 0xF);
+                    }
+                }
+                static const int offsets[6][3] {
+                    {0, 1, 0}, {0, -1, 0}, {1, 0, 0}, {-1, 0, 0}, {0, 0, 1}, {0, 0, -1}
+                };
+                for (const auto& offset : offsets) {
+                    for (auto& solver : solvers) {
+                        solver->add(x + offset[0], y + offset[1], z + offset[2]);
+                    }
+                }
+                solve();
+                return;
+            }
+            if (!block->skyLightPassing) {
+                solverS.remove(x, y, z);
+                for (int i = y - 1; i >= 0; i--) {
+                    solverS.remove(x, i, z);
+                    if (i == 0 || chunks.get(x, i - 1, z)->id != 0) {
+                        break;
+                    }
+                }
+                solverS.solve();
+            }
+            solve();
+            for (int channel = 0; channel < 3; channel++) {
+                solvers[channel]->add(x, y, z, block->emission[channel]);
+            }
+            solve();
+        }
+    };
+}
+
+struct scene_blocks {
+    blockid_t stone;
+    blockid_t glass;
+    /// @brief Light sources of different colors, the last one passes light
+    blockid_t lamps[3];
+};
+
+static Content* build_content() {
+    return fixture::build_content([](ContentBuilder& builder) {
+        fixture::create_block(builder, "test:stone");
+
+        Block& glass = fixture::create_block(builder, "test:glass");
+        glass.lightPassing = true;
+
+        Block& lamp = fixture::create_block(builder, "test:lamp");
+        lamp.emission[0] = lamp.emission[1] = lamp.emission[2] = 15;
+
+        Block& redLamp = fixture::create_block(builder, "test:red_lamp");
+        redLamp.emission[0] = 15;
+        redLamp.emission[1] = 8;
+        redLamp.emission[2] = 3;
+
+        Block& blueLamp = fixture::create_block(builder, "test:blue_lamp");
+        blueLamp.lightPassing = true;
+        blueLamp.skyLightPassing = true;
+        blueLamp.emission[0] = 1;
+        blueLamp.emission[2] = 12;
+    });
+}
+
+/// @brief Scene of terrain with caves, glass and lamps,
+/// parameters are taken from the random
+struct scene {
+    float phaseX, phaseZ;
+    uint lampRarity;
+    uint caveBottom, caveTop;
+
+    scene(std::mt19937& random) {
+        phaseX = random() % 1000 * 0.01f;
+        phaseZ = random() % 1000 * 0.01f;
+        lampRarity = 50 + random() % 800;
+        caveBottom = 5 + random() % 20;
+        caveTop = caveBottom + random() % 20;
+    }
+
+    void generate(Chunk& chunk, const scene_blocks& blocks) const {
+        auto voxels = std::make_unique<voxel[]>(CHUNK_VOL);
+        for (int y = 0; y < CHUNK_H; y++) {
+            for (int z = 0; z < CHUNK_D; z++) {
+                for (int x = 0; x < CHUNK_W; x++) {
+                    int gx = chunk.x * CHUNK_W + x;
+                    int gz = chunk.z * CHUNK_D + z;
+                    int height = 64 + int(20 * std::sin(gx * 0.05 + phaseX) +
+                                          15 * std::cos(gz * 0.07 + phaseZ));
+                    uint hash = uint(gx) * 73856093u ^
+                                uint(y) * 19349663u ^
+                                uint(gz) * 83492791u;
+                    blockid_t id = y < height ? blocks.stone : 0;
+                    if (y < height && y > 30 && hash % 37 == 0) {
+                        id = 0;
+                    }
+                    if (y < height && hash % lampRarity == 0) {
+                        id = blocks.lamps[hash / lampRarity % 3];
+                    }
+                    if (y == height && hash % 7 == 0) {
+                        id = blocks.glass;
+                    }
+                    if (uint(y) >= caveBottom && uint(y) < caveTop) {
+                        bool lamp = uint(y) == caveBottom && hash % lampRarity == 0;
+                        id = lamp ? blocks.lamps[hash % 3] : 0;
+                    }
+                    voxels[vox_index(x, y, z)] = voxel {id, 0};
+                }
+            }
+        }
+        chunk.voxels.set(voxels.get());
+    }
+};
+
+static std::unique_ptr<Chunks> create_chunks(
+    const scene& scene, const scene_blocks& blocks,
+    LevelEvents& events, const Content* content
+) {
+    auto chunks = std::make_unique<Chunks>(
+        AREA_SIZE, AREA_SIZE, 0, 0, nullptr, &events, content
+    );
+    for (int z = 0; z < AREA_SIZE; z++) {
+        for (int x = 0; x < AREA_SIZE; x++) {
+            auto chunk = std::make_shared<Chunk>(x, z);
+            scene.generate(*chunk, blocks);
+            chunk->updateHeights(content->getIndices());
+            Lighting::prebuildSkyLight(chunk.get());
+            chunk->setLoaded(true);
+            chunks->putChunk(chunk);
+        }
+    }
+    return chunks;
+}
+
+/// @return number of voxels having different light
+static size_t compare(Chunks& a, Chunks& b) {
+    size_t different = 0;
+    for (int z = 0; z < AREA_SIZE; z++) {
+        for (int x = 0; x < AREA_SIZE; x++) {
+            const auto& lightsA = a.getChunk(x, z)->lightmap.map;
+            const auto& lightsB = b.getChunk(x, z)->lightmap.map;
+            for (uint i = 0; i < CHUNK_VOL; i++) {
+                different += lightsA[i] != lightsB[i];
+            }
+        }
+    }
+    return different;
+}
+
+int main() {
+    std::unique_ptr<Content> content (build_content());
+    auto indices = content->getIndices();
+    scene_blocks blocks {
+        content->requireBlock("test:stone").rt.id,
+        content->requireBlock("test:glass").rt.id,
+        {
+            content->requireBlock("test:lamp").rt.id,
+            content->requireBlock("test:red_lamp").rt.id,
+            content->requireBlock("test:blue_lamp").rt.id
+        }
+    };
+    const blockid_t palette[] {
+        0, 0, 0, blocks.stone, blocks.stone, blocks.glass,
+        blocks.lamps[0], blocks.lamps[1], blocks.lamps[2]
+    };
+
+    int failed = 0;
+    std::mt19937 random(5);
+    for (int i = 0; i < SCENES; i++) {
+        scene current(random);
+        LevelEvents events;
+        auto expectedChunks = create_chunks(current, blocks, events, content.get());
+        auto actualChunks = create_chunks(current, blocks, events, content.get());
+
+        reference::Lighting expected(indices, *expectedChunks);
+        Lighting actual(content.get(), actualChunks.get());
+        for (int z = 1; z < AREA_SIZE - 1; z++) {
+            for (int x = 1; x < AREA_SIZE - 1; x++) {
+                expected.buildSkyLight(x, z);
+                expected.onChunkLoaded(x, z);
+                actual.buildSkyLight(x, z);
+                actual.onChunkLoaded(x, z, true);
+            }
+        }
+        size_t different = compare(*expectedChunks, *actualChunks);
+
+        // edits are made inside of the chunks lit
+        int lastEdit = -1;
+        for (int edit = 0; edit < EDITS && different == 0; edit++) {
+            int x = CHUNK_W + random() % (CHUNK_W * (AREA_SIZE - 2));
+            int z = CHUNK_D + random() % (CHUNK_D * (AREA_SIZE - 2));
+            int y = random() % 2 ? current.caveBottom + random() % 20
+                                 : 30 + random() % 80;
+            blockid_t id = palette[random() % std::size(palette)];
+            expectedChunks->set(x, y, z, id, 0);
+            actualChunks->set(x, y, z, id, 0);
+            expected.onBlockSet(x, y, z, id);
+            actual.onBlockSet(x, y, z, id);
+            actual.flush();
+            if (edit % CHECK_EDITS == CHECK_EDITS - 1) {
+                different = compare(*expectedChunks, *actualChunks);
+                lastEdit = edit;
+            }
+        }
+        std::cout << "scene " << i << ": ";
+        if (different) {
+            std::cout << "FAILED, " << different << " voxels differ";
+            if (lastEdit >= 0) {
+                std::cout << " after edit " << lastEdit;
+            }
+            std::cout << std::endl;
+            failed++;
+        } else {
+            std::cout << "ok" << std::endl;
+        }
+    }
+    return failed ? 1 : 0;
+}
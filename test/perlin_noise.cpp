@@ -0,0 +1,123 @@
+// PerlinNoise batch test: compares noise and fbm of points evaluated
+// in batches (vectorized if SSE2 or AVX2 is enabled for the build) with
+// the point-wise scalar evaluation.
+// Built with -DVOXELENGINE_BUILD_TESTS=ON
+#include "maths/PerlinNoise.h"
+
+#include <cmath>
+#include <vector>
+#include <random>
+#include <numeric>
+#include <iostream>
+#include <algorithm>
+
+inline constexpr size_t POINTS = 100000;
+/// @brief Max absolute difference allowed (batch code may differ
+/// in rounding if the scalar code is contracted to FMA)
+inline constexpr float TOLERANCE = 1e-5f;
+inline constexpr int OCTAVES = 4;
+inline constexpr float PERSISTENCE = 0.5f;
+
+struct points {
+    std::vector<float> x, y, z;
+
+    void add(float px, float py, float pz) {
+        x.push_back(px);
+        y.push_back(py);
+        z.push_back(pz);
+    }
+
+    size_t size() const {
+        return x.size();
+    }
+};
+
+/// @brief Random points of different scales, points on the lattice
+/// and around zero (negative coords are floored differently)
+static points make_points(std::mt19937& random) {
+    points points;
+    std::uniform_real_distribution<float> small(-4.0f, 4.0f);
+    std::uniform_real_distribution<float> large(-300000.0f, 300000.0f);
+    std::uniform_int_distribution<int> lattice(-1000, 1000);
+    for (size_t i = 0; i < POINTS; i++) {
+        switch (i % 4) {
+            case 0: points.add(small(random), small(random), small(random)); break;
+            case 1: points.add(large(random), large(random), large(random)); break;
+            case 2: points.add(lattice(random), lattice(random), lattice(random)); break;
+            case 3: points.add(large(random), 0.0f, large(random)); break;
+        }
+    }
+    return points;
+}
+
+/// @param batch evaluates noise of count points starting at offset
+/// @param scalar evaluates noise of the point index
+/// @return max absolute difference of the batch and the scalar results
+template<class B, class S>
+static float compare(const points& points, const B& batch, const S& scalar) {
+    std::vector<float> values(points.size());
+    // different counts check the remainder of the vector width
+    size_t offset = 0;
+    for (size_t count = 1; offset < points.size(); count = count % 150 + 1) {
+        count = std::min(count, points.size() - offset);
+        batch(offset, count, values.data() + offset);
+        offset += count;
+    }
+    float maxDifference = 0.0f;
+    for (size_t i = 0; i < points.size(); i++) {
+        float difference = std::abs(values[i] - scalar(i));
+        if (!(difference <= maxDifference)) {
+            maxDifference = difference;
+        }
+    }
+    return maxDifference;
+}
+
+static bool check(const char* name, float difference) {
+    bool passed = difference <= TOLERANCE;
+    std::cout << name << ": max difference " << difference
+              << (passed ? " ok" : " FAILED") << std::endl;
+    return passed;
+}
+
+int main() {
+    std::mt19937 random(11);
+    auto points = make_points(random);
+
+    int permutation[256];
+    std::iota(permutation, permutation + 256, 0);
+    std::shuffle(permutation, permutation + 256, random);
+
+    int failed = 0;
+    const int* tables[] {PerlinNoise::REFERENCE_PERMUTATION, permutation};
+    for (const int* table : tables) {
+        PerlinNoise perlin(table);
+        float noiseDifference = compare(points,
+            [&](size_t offset, size_t count, float* dst) {
+                perlin.noise(
+                    &points.x[offset], &points.y[offset], &points.z[offset],
+                    dst, count
+                );
+            },
+            [&](size_t i) {
+                return perlin.noise(points.x[i], points.y[i], points.z[i]);
+            }
+        );
+        float fbmDifference = compare(points,
+            [&](size_t offset, size_t count, float* dst) {
+                perlin.fbm(
+                    &points.x[offset], &points.y[offset], &points.z[offset],
+                    dst, count, OCTAVES, PERSISTENCE
+                );
+            },
+            [&](size_t i) {
+                return perlin.fbm(
+                    points.x[i], points.y[i], points.z[i], OCTAVES, PERSISTENCE
+                );
+            }
+        );
+        failed += !check("noise", noiseDifference);
+        failed += !check("fbm", fbmDifference);
+    }
+    return failed ? 1 : 0;
+}